@@ -0,0 +1,153 @@
+#include <compiler.h>
+#include <fifo_deque.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Work Stealing Benchmark
+ *
+ * Runs one owner and 0 to N thieves on a fifo_deque_t and reports the number
+ * of tasks taken per second for two workloads:
+ *
+ *   owner  the owner pushes tasks in batches and pops them again itself, the
+ *          thieves only get what they manage to steal in between
+ *   steal  the owner only pushes, every task is taken by a thief
+ *
+ * N defaults to the number of online cores less one and can be given as the
+ * first argument.
+ */
+
+#define BENCH__TASKS                                (1 << 22)
+#define BENCH__BATCH                                32
+
+typedef enum {
+  BENCH__OWNER,
+  BENCH__STEAL,
+} bench__workload_t;
+
+static fifo_deque_t     bench__deque;
+static _Atomic(size_t)  bench__taken;
+static _Atomic(bool_t)  bench__running;
+
+
+static double bench__now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *bench__thief(void *arg)
+{
+  size_t taken = 0;
+  void  *task;
+
+  while (atomic_load_explicit(&bench__running, memory_order_relaxed)) {
+    if (fifo_deque__steal(&bench__deque, &task)) {
+      taken ++;
+    } else {
+      sched_yield();
+    }
+  }
+
+  atomic_fetch_add(&bench__taken, taken);
+
+  return NULL;
+}
+
+/* The owner side of a workload. Returns the number of tasks it popped. */
+static size_t bench__owner(bench__workload_t workload)
+{
+  size_t popped = 0;
+  size_t pushed = 0;
+  void  *task;
+
+  while (pushed < BENCH__TASKS) {
+    size_t i;
+
+    for (i = 0; i < BENCH__BATCH; i ++) {
+      fifo_deque__push(&bench__deque, &bench__deque);
+    }
+
+    pushed += BENCH__BATCH;
+
+    if (workload == BENCH__OWNER) {
+      while (fifo_deque__pop(&bench__deque, &task)) {
+        popped ++;
+      }
+    } else if (fifo_deque__used(&bench__deque) > BENCH__BATCH * 64) {
+      sched_yield();
+    }
+  }
+
+  return popped;
+}
+
+/* Returns the number of tasks taken per second with the given number of
+ * thieves.
+ */
+static double bench__run(bench__workload_t workload, size_t thieves)
+{
+  pthread_t threads[thieves + 1];
+  double    start;
+  size_t    popped;
+  size_t    i;
+
+  fifo_deque__ctor(&bench__deque, 1024);
+  atomic_store(&bench__taken, 0);
+  atomic_store(&bench__running, 1);
+
+  start = bench__now();
+
+  for (i = 0; i < thieves; i ++) {
+    pthread_create(&threads[i], NULL, bench__thief, NULL);
+  }
+
+  popped = bench__owner(workload);
+
+  /* Wait until the thieves have taken what is left */
+  while (thieves > 0 && fifo_deque__used(&bench__deque) > 0) {
+    sched_yield();
+  }
+
+  atomic_store(&bench__running, 0);
+
+  for (i = 0; i < thieves; i ++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  popped += atomic_load(&bench__taken);
+
+  fifo_deque__dtor(&bench__deque);
+
+  return popped / (bench__now() - start);
+}
+
+int main(int argc, char *argv[])
+{
+  size_t max_thieves;
+  size_t thieves;
+
+  if (argc > 1) {
+    max_thieves = strtoul(argv[1], NULL, 10);
+  } else {
+    max_thieves = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+  }
+
+  printf("%8s %16s %16s\n", "thieves", "owner [Mtask/s]", "steal [Mtask/s]");
+
+  for (thieves = 0; thieves <= max_thieves; thieves ++) {
+    double const owner_rate = bench__run(BENCH__OWNER, thieves);
+    double const steal_rate = thieves > 0 ? bench__run(BENCH__STEAL, thieves)
+                                          : 0;
+
+    printf("%8zu %16.2f %16.2f\n", thieves, owner_rate / 1e6,
+           steal_rate / 1e6);
+  }
+
+  return 0;
+}
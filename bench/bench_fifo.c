@@ -0,0 +1,283 @@
+#include <compiler.h>
+#include <fifo.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Fifo Benchmark
+ *
+ * Measures the core operations of the wide fifos and prints one result per
+ * line, as CSV by default or as a JSON array when "json" is given as the first
+ * argument, so that results of different releases can be compared by script:
+ *
+ *   throughput  bytes per second through write/read, per buffer and chunk size
+ *   grow        nanoseconds per resize to twice the size, with wrapped data
+ *   shrink      nanoseconds per resize to half the size, with data to move
+ *   latency     nanoseconds per round trip between two threads, as
+ *               percentiles. Without FIFO__SPSC the fifos are not thread
+ *               safe, so each call is guarded by a mutex and the results are
+ *               reported as latency_locked instead.
+ */
+
+#define BENCH__SIZE_MAX                             (1 << 20)
+#define BENCH__TOTAL_BYTES                          (64 * 1024 * 1024)
+#define BENCH__RESIZES                              256
+#define BENCH__ROUND_TRIPS                          100000
+
+typedef enum {
+  BENCH__CSV,
+  BENCH__JSON,
+} bench__format_t;
+
+static bench__format_t bench__format = BENCH__CSV;
+static size_t          bench__results;
+
+static uint8_t bench__buffer[BENCH__SIZE_MAX * 2];
+static uint8_t bench__src[BENCH__SIZE_MAX];
+static uint8_t bench__dest[BENCH__SIZE_MAX];
+
+
+static double bench__now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Print one result in the selected format. */
+static void bench__report(char const *name, size_t size, size_t chunk,
+                          char const *metric, double value, char const *unit)
+{
+  if (bench__format == BENCH__JSON) {
+    printf("%s  {\"benchmark\": \"%s\", \"size\": %zu, \"chunk\": %zu, "
+           "\"metric\": \"%s\", \"value\": %.1f, \"unit\": \"%s\"}",
+           bench__results ? ",\n" : "[\n", name, size, chunk, metric, value,
+           unit);
+  } else {
+    if (bench__results == 0) {
+      puts("benchmark,size,chunk,metric,value,unit");
+    }
+
+    printf("%s,%zu,%zu,%s,%.1f,%s\n", name, size, chunk, metric, value, unit);
+  }
+
+  bench__results ++;
+}
+
+
+/* Throughput ----------------------------------------------------------------*/
+
+/* Moves BENCH__TOTAL_BYTES through a fifo of the given size in chunks and
+ * reports the throughput. The cursors are offset so that chunks straddle the
+ * edge of the buffer.
+ */
+static void bench__throughput(size_t size, size_t chunk)
+{
+  fifo32_t fifo;
+  size_t   moved = 0;
+  double   start;
+
+  fifo32__ctor(&fifo, bench__buffer, size);
+
+  fifo32__write(&fifo, bench__src, 3);
+  fifo32__read(&fifo, bench__dest, 3);
+
+  start = bench__now();
+
+  while (moved < BENCH__TOTAL_BYTES) {
+    fifo32__write(&fifo, bench__src, chunk);
+    moved += fifo32__read(&fifo, bench__dest, chunk);
+  }
+
+  bench__report("throughput", size, chunk, "rate",
+                BENCH__TOTAL_BYTES / (bench__now() - start), "B/s");
+}
+
+
+/* Resize --------------------------------------------------------------------*/
+
+/* Reports the time it takes to double a fifo that is three quarters full and
+ * whose data wraps around the edge, and to halve it again, which moves the
+ * data back.
+ */
+static void bench__resize(size_t size)
+{
+  fifo32_t fifo;
+  double   grow   = 0;
+  double   shrink = 0;
+  size_t   i;
+
+  for (i = 0; i < BENCH__RESIZES; i ++) {
+    double start;
+
+    /* [. . . . . . . .] -> [6 7 . . 2 3 4 5] */
+    fifo32__ctor(&fifo, bench__buffer, size);
+    fifo32__write(&fifo, bench__src, size - size / 4);
+    fifo32__read(&fifo, bench__dest, size / 2);
+    fifo32__write(&fifo, bench__src, size / 2);
+
+    start = bench__now();
+    fifo32__resize(&fifo, size * 2);
+    grow += bench__now() - start;
+
+    /* The data now runs past the edge of the original size */
+    start = bench__now();
+    fifo32__resize(&fifo, size);
+    shrink += bench__now() - start;
+  }
+
+  bench__report("grow", size, 0, "mean", grow / BENCH__RESIZES * 1e9, "ns");
+  bench__report("shrink", size * 2, 0, "mean",
+                shrink / BENCH__RESIZES * 1e9, "ns");
+}
+
+
+/* Latency -------------------------------------------------------------------*/
+
+#ifdef FIFO__SPSC
+#define BENCH__LATENCY                              "latency"
+#else
+#define BENCH__LATENCY                              "latency_locked"
+
+static pthread_mutex_t bench__lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static fifo_t  bench__ping;
+static fifo_t  bench__pong;
+static uint8_t bench__ping_buffer[64];
+static uint8_t bench__pong_buffer[64];
+
+/* Writes a byte to a fifo shared with another thread. */
+static void bench__send(fifo_t *fifo, uint8_t byte)
+{
+#ifndef FIFO__SPSC
+  pthread_mutex_lock(&bench__lock);
+#endif
+  fifo__write(fifo, &byte, 1);
+#ifndef FIFO__SPSC
+  pthread_mutex_unlock(&bench__lock);
+#endif
+}
+
+/* Reads a byte from a fifo shared with another thread, yielding until there
+ * is one.
+ */
+static uint8_t bench__receive(fifo_t *fifo)
+{
+  uint8_t byte;
+  size_t  len;
+
+  for (;;) {
+#ifndef FIFO__SPSC
+    pthread_mutex_lock(&bench__lock);
+#endif
+    len = fifo__read(fifo, &byte, 1);
+#ifndef FIFO__SPSC
+    pthread_mutex_unlock(&bench__lock);
+#endif
+
+    if (len > 0) {
+      return byte;
+    }
+
+    sched_yield();
+  }
+}
+
+/* Sends every byte received on ping straight back on pong. */
+static void *bench__echo(void *arg)
+{
+  size_t i;
+
+  for (i = 0; i < BENCH__ROUND_TRIPS; i ++) {
+    bench__send(&bench__pong, bench__receive(&bench__ping));
+  }
+
+  return NULL;
+}
+
+static int bench__compare(void const *a, void const *b)
+{
+  double const x = *(double const *) a;
+  double const y = *(double const *) b;
+
+  return (x > y) - (x < y);
+}
+
+/* Reports percentiles of the time it takes a byte to travel to another thread
+ * and back.
+ */
+static void bench__latency(void)
+{
+  static double const percentiles[] = { 50, 90, 99, 99.9 };
+  static double       samples[BENCH__ROUND_TRIPS];
+  pthread_t echo;
+  size_t    i;
+  uint8_t   byte = 0;
+
+  fifo__ctor(&bench__ping, bench__ping_buffer, sizeof(bench__ping_buffer));
+  fifo__ctor(&bench__pong, bench__pong_buffer, sizeof(bench__pong_buffer));
+
+  pthread_create(&echo, NULL, bench__echo, NULL);
+
+  for (i = 0; i < BENCH__ROUND_TRIPS; i ++) {
+    double const start = bench__now();
+
+    bench__send(&bench__ping, byte);
+    byte = bench__receive(&bench__pong);
+
+    samples[i] = (bench__now() - start) * 1e9;
+  }
+
+  pthread_join(echo, NULL);
+
+  qsort(samples, BENCH__ROUND_TRIPS, sizeof(samples[0]), bench__compare);
+
+  for (i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i ++) {
+    size_t const rank = BENCH__ROUND_TRIPS * percentiles[i] / 100;
+    char metric[16];
+
+    snprintf(metric, sizeof(metric), "p%g", percentiles[i]);
+    bench__report(BENCH__LATENCY, sizeof(bench__ping_buffer), 1, metric,
+                  samples[rank], "ns");
+  }
+
+  bench__report(BENCH__LATENCY, sizeof(bench__ping_buffer), 1, "max",
+                samples[BENCH__ROUND_TRIPS - 1], "ns");
+}
+
+
+int main(int argc, char *argv[])
+{
+  static size_t const sizes[]  = { 256, 4096, 65536, BENCH__SIZE_MAX };
+  static size_t const chunks[] = { 1, 16, 256, 4096 };
+  size_t i;
+  size_t j;
+
+  if (argc > 1 && strcmp(argv[1], "json") == 0) {
+    bench__format = BENCH__JSON;
+  }
+
+  for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i ++) {
+    for (j = 0; j < sizeof(chunks) / sizeof(chunks[0]); j ++) {
+      if (chunks[j] <= sizes[i]) {
+        bench__throughput(sizes[i], chunks[j]);
+      }
+    }
+  }
+
+  for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i ++) {
+    bench__resize(sizes[i]);
+  }
+
+  bench__latency();
+
+  if (bench__format == BENCH__JSON) {
+    puts(bench__results ? "\n]" : "[]");
+  }
+
+  return 0;
+}
@@ -0,0 +1,180 @@
+#include <compiler.h>
+#include <fifo.h>
+#include <fifo_mpmc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/* MPMC Scaling Benchmark
+ *
+ * Runs 1 to N producer/consumer pairs over a shared queue and reports the
+ * number of elements moved per second, for fifo_mpmc_t and for a fifo32_t
+ * guarded by a mutex. N defaults to the number of online cores and can be
+ * given as the first argument.
+ */
+
+#define BENCH__SIZE                                 1024
+#define BENCH__ELEMENT_SIZE                         16
+#define BENCH__ELEMENTS                             (1 << 20)
+
+typedef struct {
+  bool_t (*write)(void const *src);
+  bool_t (*read)(void *dest);
+  size_t   per_thread;
+} bench__queue_t;
+
+static size_t bench__mpmc_buffer[FIFO_MPMC__BUFFER_SIZE(BENCH__SIZE,
+                                                        BENCH__ELEMENT_SIZE)
+                                 / sizeof(size_t)];
+static fifo_mpmc_t bench__mpmc;
+
+static uint8_t         bench__locked_buffer[BENCH__SIZE * BENCH__ELEMENT_SIZE];
+static fifo32_t        bench__locked;
+static pthread_mutex_t bench__lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static bool_t bench__mpmc_write(void const *src)
+{
+  return fifo_mpmc__write(&bench__mpmc, src);
+}
+
+static bool_t bench__mpmc_read(void *dest)
+{
+  return fifo_mpmc__read(&bench__mpmc, dest);
+}
+
+static bool_t bench__locked_write(void const *src)
+{
+  bool_t written = 0;
+
+  pthread_mutex_lock(&bench__lock);
+
+  if (fifo32__available(&bench__locked) >= BENCH__ELEMENT_SIZE) {
+    written = fifo32__write(&bench__locked, src, BENCH__ELEMENT_SIZE) != 0;
+  }
+
+  pthread_mutex_unlock(&bench__lock);
+
+  return written;
+}
+
+static bool_t bench__locked_read(void *dest)
+{
+  bool_t read = 0;
+
+  pthread_mutex_lock(&bench__lock);
+
+  if (fifo32__used(&bench__locked) >= BENCH__ELEMENT_SIZE) {
+    read = fifo32__read(&bench__locked, dest, BENCH__ELEMENT_SIZE) != 0;
+  }
+
+  pthread_mutex_unlock(&bench__lock);
+
+  return read;
+}
+
+static void *bench__producer(void *arg)
+{
+  bench__queue_t const *queue = (bench__queue_t const *) arg;
+  uint8_t element[BENCH__ELEMENT_SIZE] = { 0 };
+  size_t  i;
+
+  for (i = 0; i < queue->per_thread; ) {
+    if (queue->write(element)) {
+      i ++;
+    } else {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+static void *bench__consumer(void *arg)
+{
+  bench__queue_t const *queue = (bench__queue_t const *) arg;
+  uint8_t element[BENCH__ELEMENT_SIZE];
+  size_t  i;
+
+  for (i = 0; i < queue->per_thread; ) {
+    if (queue->read(element)) {
+      i ++;
+    } else {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+static double bench__now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Returns the number of elements moved per second by the given number of
+ * producer/consumer pairs.
+ */
+static double bench__run(bench__queue_t *queue, size_t pairs)
+{
+  pthread_t producers[pairs];
+  pthread_t consumers[pairs];
+  double    start;
+  size_t    i;
+
+  queue->per_thread = BENCH__ELEMENTS / pairs;
+
+  start = bench__now();
+
+  for (i = 0; i < pairs; i ++) {
+    pthread_create(&consumers[i], NULL, bench__consumer, queue);
+    pthread_create(&producers[i], NULL, bench__producer, queue);
+  }
+
+  for (i = 0; i < pairs; i ++) {
+    pthread_join(producers[i], NULL);
+    pthread_join(consumers[i], NULL);
+  }
+
+  return queue->per_thread * pairs / (bench__now() - start);
+}
+
+int main(int argc, char *argv[])
+{
+  bench__queue_t mpmc   = { bench__mpmc_write,   bench__mpmc_read,   0 };
+  bench__queue_t locked = { bench__locked_write, bench__locked_read, 0 };
+  size_t max_pairs;
+  size_t pairs;
+
+  if (argc > 1) {
+    max_pairs = strtoul(argv[1], NULL, 10);
+  } else {
+    max_pairs = sysconf(_SC_NPROCESSORS_ONLN);
+  }
+
+  printf("%8s %16s %16s\n", "threads", "mpmc [Mop/s]", "mutex [Mop/s]");
+
+  for (pairs = 1; pairs <= max_pairs; pairs ++) {
+    double mpmc_rate;
+    double locked_rate;
+
+    fifo_mpmc__ctor(&bench__mpmc, bench__mpmc_buffer, BENCH__SIZE,
+                    BENCH__ELEMENT_SIZE);
+    mpmc_rate = bench__run(&mpmc, pairs);
+
+    fifo32__ctor(&bench__locked, bench__locked_buffer,
+                 sizeof(bench__locked_buffer));
+    locked_rate = bench__run(&locked, pairs);
+
+    printf("%8zu %16.2f %16.2f\n",
+           pairs * 2, mpmc_rate / 1e6, locked_rate / 1e6);
+  }
+
+  return 0;
+}
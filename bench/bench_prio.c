@@ -0,0 +1,159 @@
+#include <compiler.h>
+#include <fifo_prio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Head of Line Blocking Benchmark
+ *
+ * Keeps a backlog of BENCH__BACKLOG bulk messages queued, and repeatedly adds
+ * a small control message and reads until it comes out, adding a new bulk
+ * message for each one read to keep the backlog. Reports the median and 99th
+ * percentile of the number of bulk messages read ahead of the control message
+ * and of the time it took to come out, for:
+ *
+ *   single    one fifo32_t shared by control and bulk messages
+ *   strict    a fifo_prio_t with control on lane 0 and bulk on lane 1
+ *   weighted  the same under FIFO_PRIO__WEIGHTED, with weight 1 for control
+ *             and BENCH__BULK_WEIGHT for bulk
+ */
+
+#define BENCH__SAMPLES                              20000
+#define BENCH__BACKLOG                              256
+#define BENCH__BULK_LEN                             1024
+#define BENCH__CONTROL_LEN                          16
+#define BENCH__BULK_WEIGHT                          8
+#define BENCH__BULK_SIZE                            (1 << 19)
+#define BENCH__CONTROL_SIZE                         (1 << 12)
+
+typedef enum {
+  BENCH__SINGLE,
+  BENCH__STRICT,
+  BENCH__WEIGHTED,
+} bench__mode_t;
+
+static char const * const bench__modes[] = { "single", "strict", "weighted" };
+
+static uint8_t     bench__bulk_buffer[BENCH__BULK_SIZE];
+static uint8_t     bench__control_buffer[BENCH__CONTROL_SIZE];
+static uint8_t     bench__message[BENCH__BULK_LEN];
+static fifo32_t    bench__single;
+static fifo_prio_t bench__prio;
+static double      bench__ahead[BENCH__SAMPLES];
+static double      bench__ns[BENCH__SAMPLES];
+
+
+static double bench__now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int bench__compare(void const *a, void const *b)
+{
+  double const x = *(double const *) a;
+  double const y = *(double const *) b;
+
+  return (x > y) - (x < y);
+}
+
+/* Sorts the samples and returns the given percentile. */
+static double bench__percentile(double *samples, double percentile)
+{
+  qsort(samples, BENCH__SAMPLES, sizeof(double), bench__compare);
+
+  return samples[(size_t) (percentile / 100 * (BENCH__SAMPLES - 1))];
+}
+
+static void bench__push(bench__mode_t mode, bool_t control)
+{
+  size_t const   len  = control ? BENCH__CONTROL_LEN : BENCH__BULK_LEN;
+  fifo__result_t res;
+
+  if (mode == BENCH__SINGLE) {
+    res = fifo32__push_msg(&bench__single, bench__message, len);
+  } else {
+    res = fifo_prio__push(&bench__prio, !control, bench__message, len);
+  }
+
+  assert(res == FIFO__OK);
+  (void) res;
+}
+
+/* Reads the next message and returns non-zero if it was a control message. */
+static bool_t bench__pop(bench__mode_t mode)
+{
+  static uint8_t dest[BENCH__BULK_LEN];
+  fifo__result_t res;
+  size_t         len;
+  size_t         lane;
+
+  if (mode == BENCH__SINGLE) {
+    res = fifo32__pop_msg(&bench__single, dest, sizeof(dest), &len);
+  } else {
+    res = fifo_prio__pop(&bench__prio, dest, sizeof(dest), &len, &lane);
+  }
+
+  assert(res == FIFO__OK);
+  (void) res;
+
+  return len == BENCH__CONTROL_LEN;
+}
+
+static void bench__run(bench__mode_t mode)
+{
+  size_t sample;
+  size_t i;
+
+  if (mode == BENCH__SINGLE) {
+    fifo32__ctor(&bench__single, bench__bulk_buffer, BENCH__BULK_SIZE);
+  } else {
+    fifo_prio__ctor(&bench__prio, mode == BENCH__STRICT ? FIFO_PRIO__STRICT
+                                                        : FIFO_PRIO__WEIGHTED);
+    fifo_prio__lane_ctor(&bench__prio, 0, bench__control_buffer,
+                         BENCH__CONTROL_SIZE, 1);
+    fifo_prio__lane_ctor(&bench__prio, 1, bench__bulk_buffer,
+                         BENCH__BULK_SIZE, BENCH__BULK_WEIGHT);
+  }
+
+  for (i = 0; i < BENCH__BACKLOG; i ++) {
+    bench__push(mode, 0);
+  }
+
+  for (sample = 0; sample < BENCH__SAMPLES; sample ++) {
+    size_t       ahead = 0;
+    double const start = bench__now();
+
+    bench__push(mode, 1);
+
+    while (!bench__pop(mode)) {
+      bench__push(mode, 0);
+      ahead ++;
+    }
+
+    bench__ns[sample]    = bench__now() - start;
+    bench__ahead[sample] = ahead;
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  bench__mode_t mode;
+
+  printf("%-9s %14s %14s %14s %14s\n", "", "ahead p50", "ahead p99",
+         "latency p50", "latency p99");
+
+  for (mode = BENCH__SINGLE; mode <= BENCH__WEIGHTED; mode ++) {
+    bench__run(mode);
+
+    printf("%-9s %14.0f %14.0f %11.0f ns %11.0f ns\n", bench__modes[mode],
+           bench__percentile(bench__ahead, 50),
+           bench__percentile(bench__ahead, 99),
+           bench__percentile(bench__ns, 50),
+           bench__percentile(bench__ns, 99));
+  }
+
+  return 0;
+}
@@ -0,0 +1,69 @@
+#include <compiler.h>
+#include <fifo.h>
+#include <fifo_static.h>
+#include <time.h>
+
+/* Static Fifo Benchmark
+ *
+ * Moves small records of a constant size through a fifo_t and through a
+ * FIFO_DEFINE_STATIC fifo of the same size, and reports the number of records
+ * moved per second. The static fifo can be inlined into the loop with its mask
+ * and the record size folded into the copies.
+ */
+
+#define BENCH__FIFO_SIZE                            256
+#define BENCH__RECORDS                              (16 * 1024 * 1024)
+
+FIFO_DEFINE_STATIC(bench__static, BENCH__FIFO_SIZE)
+
+static uint8_t         bench__buffer[BENCH__FIFO_SIZE];
+static fifo_t          bench__fifo;
+static bench__static_t bench__static;
+
+
+static double bench__now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Expands to a loop that moves BENCH__RECORDS records of the given size and
+ * evaluates to the rate in records per second. */
+#define BENCH__RUN(size, write, read, fifo)                 \
+  ({                                                        \
+    uint8_t record[size] = { 0 };                           \
+    double  start = bench__now();                           \
+    size_t  i;                                              \
+                                                            \
+    for (i = 0; i < BENCH__RECORDS; i ++) {                 \
+      write(fifo, record, size);                            \
+      read(fifo, record, size);                             \
+    }                                                       \
+                                                            \
+    BENCH__RECORDS / (bench__now() - start);                \
+  })
+
+#define BENCH__ROW(size)                                    \
+  printf("%8d %16.1f %16.1f\n", size,                       \
+         BENCH__RUN(size, fifo__write, fifo__read,          \
+                    &bench__fifo) / 1e6,                    \
+         BENCH__RUN(size, bench__static__write,             \
+                    bench__static__read, &bench__static) / 1e6)
+
+int main(int argc, char *argv[])
+{
+  fifo__ctor(&bench__fifo, bench__buffer, sizeof(bench__buffer));
+
+  printf("%8s %16s %16s\n", "record", "fifo_t [M/s]", "static [M/s]");
+
+  BENCH__ROW(1);
+  BENCH__ROW(4);
+  BENCH__ROW(8);
+  BENCH__ROW(16);
+  BENCH__ROW(32);
+
+  return 0;
+}
@@ -31,5 +31,14 @@ typedef uint_fast8_t bool_t;
 #define NONNULL_ARGS(...)                                   \
   __attribute__((__nonnull__ (__VA_ARGS__)))
 #define PURE                                      __attribute__((__pure__))
+#define NOINLINE                                  __attribute__((__noinline__))
+#define ALIGNED(n)                                          \
+  __attribute__((__aligned__ (n)))
+
+/* Size of the cache lines of the target, used to keep data written by
+   different cores apart. */
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE                           64
+#endif
 
 #endif /* COMPILER_H */
\ No newline at end of file
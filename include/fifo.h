@@ -5,6 +5,63 @@
  * The smallest buffer size the fifo can support is 4 bytes. This is a result of
  * how the size is stored internally and needed to correctly handle zero size
  * buffers.
+ *
+ * Wider variants of the fifo are available for larger buffers. They share the
+ * semantics of fifo_t but use wider indices, and are named after their index
+ * width:
+ *
+ *   Type       Index     Maximum size
+ *   fifo_t     uint8_t   FIFO__SIZE_MAX   = 2^8
+ *   fifo16_t   uint16_t  FIFO16__SIZE_MAX = 2^16
+ *   fifo32_t   uint32_t  FIFO32__SIZE_MAX = 2^32 (2^31 on 32 bit targets)
+ *   fifosz_t   size_t    FIFOSZ__SIZE_MAX = half the address space
+ *
+ * The wide variants can also be constructed with fifo16__ctor_mirrored etc.
+ * on a buffer that is mapped twice back to back, see fifo_mirror.h. For a fifo
+ * shared between processes see fifo_shm.h.
+ *
+ * SPSC mode
+ * Defining FIFO__SPSC when building both the library and the application makes
+ * every fifo safe to use from one producer and one consumer thread at the same
+ * time, without locks. The producer may call write, the consumer read and
+ * flush, and both may query the fifo. The constructor and resize must not run
+ * concurrently with anything else. Cursors are wider in this mode, see
+ * fifo_template.h.
+ *
+ * Additionally defining FIFO__CACHE_ALIGNED puts the producer and consumer
+ * state of each fifo on separate cache lines, so that neither side invalidates
+ * the cache line of the other on every call. The fifos become a lot larger,
+ * so this is meant for fifos linking threads on different cores.
+ *
+ * Blocking
+ * Defining FIFO__WAIT as well adds fifo__read_wait and fifo__write_wait, which
+ * block until data or space is available, spinning briefly before sleeping on
+ * a futex. Every write and read then checks for sleeping threads, at the cost
+ * of one load, and makes a system call only if there are any. The memory
+ * barrier this check needs is paid by the thread going to sleep, with
+ * membarrier. Where that is not available every write and read costs a
+ * memory fence as well. Linux only.
+ *
+ * File descriptors
+ * On Unix like systems the fifos can be filled from and drained to file
+ * descriptors directly with fifo__read_from_fd and fifo__write_to_fd, and
+ * fifo__writev and fifo__readv copy from and to iovec arrays.
+ *
+ * Statistics
+ * Defining FIFO__STATS adds counters of the bytes written and read, short
+ * writes, empty reads, the highest fill level and resizes to every fifo, see
+ * fifo__stats. Each counter is only updated by one side, so in SPSC mode they
+ * are plain loads and stores rather than atomic increments.
+ *
+ * Checksums
+ * fifo__write_crc and fifo__read_crc compute the CRC32C of the data while they
+ * copy it, see src/fifo_crc.c. fifo__crc32c checksums plain buffers, e.g. to
+ * verify a message on the other side.
+ *
+ * Event loops
+ * Defining FIFO__NOTIFY with FIFO__SPSC adds fifo__notify_ctor, which gives a
+ * fifo a pair of eventfds for use with epoll. See fifo__notify_ctor for the
+ * details. Linux only.
  */
 
 #ifndef FIFO_H
@@ -14,99 +71,180 @@
 
 #include <compiler.h>
 
+/* Options that cannot be used are reported and then dropped, so that the rest
+   compiles without them and the error is the only one. */
+#ifndef FIFO__SPSC
+#ifdef FIFO__CACHE_ALIGNED
+#error "FIFO__CACHE_ALIGNED requires FIFO__SPSC"
+#undef FIFO__CACHE_ALIGNED
+#endif
+#ifdef FIFO__WAIT
+#error "FIFO__WAIT requires FIFO__SPSC"
+#undef FIFO__WAIT
+#endif
+#ifdef FIFO__NOTIFY
+#error "FIFO__NOTIFY requires FIFO__SPSC"
+#undef FIFO__NOTIFY
+#endif
+#endif
+
+#ifndef __linux__
+#ifdef FIFO__WAIT
+#error "FIFO__WAIT is only supported on Linux"
+#undef FIFO__WAIT
+#endif
+#ifdef FIFO__NOTIFY
+#error "FIFO__NOTIFY is only supported on Linux"
+#undef FIFO__NOTIFY
+#endif
+#endif
+
+#ifdef FIFO__SPSC
+#include <stdatomic.h>
+#endif
+
+#ifdef __unix__
+#include <sys/uio.h>
+#endif
 
 #define FIFO__SIZE_MAX                            256
 #define FIFO__SIZE_MIN                            4
 
+#define FIFO16__SIZE_MAX                          0x10000
+#if SIZE_MAX > 0xFFFFFFFF
+#define FIFO32__SIZE_MAX                          0x100000000
+#else
+#define FIFO32__SIZE_MAX                          0x80000000
+#endif
+#define FIFOSZ__SIZE_MAX                          ((SIZE_MAX >> 1) + 1)
 
-/* Data Types --------------------------------------------------------------- */
 
-/* Main FIFO data type.
- * Size: 2+3 = 5 bytes.
- */
-typedef struct fifo {
-  uint8_t * const buffer;
-  uint8_t volatile mask;
-  uint8_t volatile read;
-  uint8_t volatile write;
-} fifo_t;
+/* Data Types --------------------------------------------------------------- */
 
 typedef enum {
   FIFO__OK = 0,
   FIFO__EMPTY,
   FIFO__FULL,
   FIFO__INVALID_SIZE,
+  FIFO__SYSTEM_ERROR,
 } fifo__result_t;
 
-
-/* Macros ------------------------------------------------------------------- */
-
-
+#ifdef FIFO__STATS
+#ifdef FIFO__SPSC
+typedef _Atomic(uint64_t) fifo__counter_t;
+#else
+typedef uint64_t fifo__counter_t;
+#endif
+
+/* Counters updated by the producer, and by resize. */
+typedef struct {
+  fifo__counter_t bytes_written;
+  fifo__counter_t short_writes;
+  fifo__counter_t high_water;
+  fifo__counter_t resizes;
+} fifo__producer_stats_t;
+
+/* Counters updated by the consumer. */
+typedef struct {
+  fifo__counter_t bytes_read;
+  fifo__counter_t empty_reads;
+} fifo__consumer_stats_t;
+
+/* Snapshot of the counters of a fifo, returned by fifo__stats.
+ *
+ *   bytes_written  Bytes added to the fifo, by any function.
+ *   bytes_read     Bytes removed from the fifo, including those discarded by
+ *                  flush and write_force, so the difference of the two is
+ *                  always the number of bytes used.
+ *   short_writes   Writes that stored less than asked for, or nothing.
+ *   empty_reads    Reads that found nothing to read.
+ *   high_water     The highest number of bytes used after a write.
+ *   resizes        Successful changes of the size.
+ */
+typedef struct {
+  uint64_t bytes_written;
+  uint64_t bytes_read;
+  uint64_t short_writes;
+  uint64_t empty_reads;
+  uint64_t high_water;
+  uint64_t resizes;
+} fifo__stats_t;
+#endif
+
+/* A contiguous part of the fifo buffer, handed out by the reserve and peek
+ * functions.
+ */
+typedef struct {
+  uint8_t *data;
+  size_t   len;
+} fifo__region_t;
 
 
-/* Global Variables --------------------------------------------------------- */
+/* Public Functions --------------------------------------------------------- */
 
+uint32_t
+  fifo__crc32c(uint32_t crc, void const *data, size_t len)
+  NONNULL;
 
 
+/* Instances ---------------------------------------------------------------- */
 
-/* Public Functions --------------------------------------------------------- */
+/* fifo_t */
+#define FIFO_T__NAME                              fifo
+#define FIFO_T__INDEX                             uint8_t
+#define FIFO_T__CURSOR                            uint16_t
+#include <fifo_template.h>
 
-void
-  fifo__ctor(fifo_t *fifo, void *buffer, size_t size)
-  NONNULL_ARGS(1);
-  
-fifo__result_t
-  fifo__resize(fifo_t *fifo, size_t new_size)
-  NONNULL;
+/* fifo16_t */
+#define FIFO_T__NAME                              fifo16
+#define FIFO_T__INDEX                             uint16_t
+#define FIFO_T__CURSOR                            uint32_t
+#define FIFO_T__MIRROR                            1
+#include <fifo_template.h>
 
-void
-  fifo__flush(fifo_t *fifo)
-  NONNULL;
+/* fifo32_t */
+#define FIFO_T__NAME                              fifo32
+#define FIFO_T__INDEX                             uint32_t
+#define FIFO_T__CURSOR                            uint64_t
+#define FIFO_T__MIRROR                            1
+#include <fifo_template.h>
 
-static inline bool_t
-  fifo__is_full(fifo_t const *fifo)
-  NONNULL;
-  
-bool_t
-  fifo__is_empty(fifo_t const *fifo)
-  NONNULL;
-  
-size_t
-  fifo__size(fifo_t const *fifo)
-  NONNULL;
-  
-size_t
-  fifo__used(fifo_t const *fifo)
-  NONNULL;
-  
-size_t
-  fifo__available(fifo_t const *fifo)
-  NONNULL;
-  
-size_t
-  fifo__write(fifo_t *fifo, void const *src, size_t len)
-  NONNULL;
-  
-bool_t
-  fifo__write_force(fifo_t *fifo, void const *src, size_t len)
-  NONNULL;
+/* fifosz_t */
+#define FIFO_T__NAME                              fifosz
+#define FIFO_T__INDEX                             size_t
+#define FIFO_T__CURSOR                            size_t
+#define FIFO_T__MIRROR                            1
+#include <fifo_template.h>
 
-size_t
-  fifo__read(fifo_t *fifo, void *dest, size_t size)
-  NONNULL;
-  
 
 /* Inline Function Definitions ---------------------------------------------- */
-  
-/* Is Full
+
+/* Size to Mask
  *
- * Returns non-zero if the fifo is full.
- * The lowest bit of the mask is used to indicate a full buffer.
+ * Returns the mask of the largest power of 2 that fits in size, or 0 if size is
+ * 0.
  */
-bool_t
-fifo__is_full(fifo_t const *fifo)
+static inline size_t
+fifo__size_to_mask(size_t size)
 {
-  return ~fifo->mask & 0x01; // || FIFO__IS_ZERO_SIZE(fifo);
+  size_t mask;
+
+  /* Set every bit below the highest 1 in size. */
+  mask = size >> 1;
+  mask |= mask >> 1;
+  mask |= mask >> 2;
+  mask |= mask >> 4;
+#if SIZE_MAX > 0xFF
+  mask |= mask >> 8;
+#endif
+#if SIZE_MAX > 0xFFFF
+  mask |= mask >> 16;
+#endif
+#if SIZE_MAX > 0xFFFFFFFF
+  mask |= mask >> 32;
+#endif
+
+  return mask;
 }
 
-#endif /* FIFO_H */
\ No newline at end of file
+#endif /* FIFO_H */
@@ -0,0 +1,274 @@
+/* Fifo C++
+ *
+ * Header only ring of elements of type T for C++17 and later. fifo::ring<T, N>
+ * uses the scheme of FIFO_DEFINE_STATIC in fifo_static.h: the size N is a
+ * constant power of 2, the storage is embedded and the cursors are free
+ * running counters that are masked when indexing. Unlike the C fifos it
+ * constructs elements in place and moves them out, so T may be any movable
+ * type.
+ *
+ *   fifo::ring<std::string, 64> ring;
+ *
+ *   ring.emplace(5, 'x');
+ *   std::optional<std::string> text = ring.pop();
+ *
+ * The cursors are always atomic and on separate cache lines, so one producer
+ * and one consumer thread may use a ring at the same time, as with FIFO__SPSC
+ * and FIFO__CACHE_ALIGNED.
+ *
+ * For trivially copyable T, readable() and writable() return the used and the
+ * free elements as two spans, the second of which starts at the beginning of
+ * the storage, like fifo__read_peek and fifo__write_reserve. consume() and
+ * commit() then remove or add elements. The spans are std::span where the
+ * standard library has it, and fifo::span with the same basic interface
+ * otherwise.
+ */
+
+#ifndef FIFO_HPP
+#define FIFO_HPP 1
+
+/* Includes ----------------------------------------------------------------- */
+
+#include <compiler.h>
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#if __has_include(<span>)
+#include <span>
+#endif
+
+
+namespace fifo {
+
+/* Span --------------------------------------------------------------------- */
+
+#if defined(__cpp_lib_span)
+
+template <typename T>
+using span = std::span<T>;
+
+#else
+
+/* Contiguous run of elements, the subset of std::span needed by ring. */
+template <typename T>
+class span {
+public:
+  constexpr span() noexcept = default;
+  constexpr span(T *data, std::size_t size) noexcept
+    : data_(data), size_(size) {}
+
+  constexpr T *data() const noexcept { return data_; }
+  constexpr std::size_t size() const noexcept { return size_; }
+  constexpr bool empty() const noexcept { return size_ == 0; }
+
+  constexpr T *begin() const noexcept { return data_; }
+  constexpr T *end() const noexcept { return data_ + size_; }
+
+  constexpr T &operator[](std::size_t i) const noexcept { return data_[i]; }
+
+private:
+  T          *data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+#endif
+
+
+/* Ring --------------------------------------------------------------------- */
+
+template <typename T, std::size_t N>
+class ring {
+  static_assert(N >= 2 && (N & (N - 1)) == 0,
+                "fifo::ring size must be a power of 2");
+
+public:
+  using value_type = T;
+
+  static constexpr std::size_t mask = N - 1;
+
+  static constexpr std::size_t capacity() noexcept { return N; }
+
+  ring() noexcept = default;
+  ring(ring const &) = delete;
+  ring &operator=(ring const &) = delete;
+
+  ~ring() { clear(); }
+
+  /* Returns the number of elements in the ring. */
+  std::size_t size() const noexcept
+  {
+    /* Load read first, write can only have moved further ahead of it */
+    std::size_t const read = read_.load(std::memory_order_acquire);
+
+    return write_.load(std::memory_order_acquire) - read;
+  }
+
+  std::size_t available() const noexcept { return N - size(); }
+  bool empty() const noexcept { return size() == 0; }
+  bool full() const noexcept { return size() == N; }
+
+  /* Construct an element from args at the end. Returns false if full. */
+  template <typename... Args>
+  bool emplace(Args &&... args)
+  {
+    std::size_t const write = write_.load(std::memory_order_relaxed);
+
+    if (write - read_.load(std::memory_order_acquire) == N) {
+      return false;
+    }
+
+    ::new (static_cast<void *>(slot(write))) T(std::forward<Args>(args)...);
+    write_.store(write + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  bool push(T const &value) { return emplace(value); }
+  bool push(T &&value) { return emplace(std::move(value)); }
+
+  /* Move the first element to value. Returns false if empty. */
+  bool pop(T &value)
+  {
+    std::size_t const read = read_.load(std::memory_order_relaxed);
+
+    if (write_.load(std::memory_order_acquire) == read) {
+      return false;
+    }
+
+    value = std::move(*slot(read));
+    slot(read)->~T();
+    read_.store(read + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  /* Remove and return the first element, if there is one. */
+  std::optional<T> pop()
+  {
+    std::size_t const read = read_.load(std::memory_order_relaxed);
+
+    if (write_.load(std::memory_order_acquire) == read) {
+      return std::nullopt;
+    }
+
+    std::optional<T> value(std::move(*slot(read)));
+
+    slot(read)->~T();
+    read_.store(read + 1, std::memory_order_release);
+
+    return value;
+  }
+
+  /* The first element. The ring must not be empty. */
+  T &front() noexcept
+  {
+    assert(!empty());
+
+    return *slot(read_.load(std::memory_order_relaxed));
+  }
+
+  /* Destroy all elements. Must be called by the consumer. */
+  void clear() noexcept
+  {
+    std::size_t       read  = read_.load(std::memory_order_relaxed);
+    std::size_t const write = write_.load(std::memory_order_acquire);
+
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      for (; read != write; read ++) {
+        slot(read)->~T();
+      }
+    }
+
+    read_.store(write, std::memory_order_release);
+  }
+
+  /* The used elements, as one run up to the end of the storage and one from
+     the start of it. */
+  std::array<span<T const>, 2> readable() const noexcept
+  {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "views need trivially copyable elements");
+
+    std::size_t const read = read_.load(std::memory_order_relaxed);
+    std::size_t const used = write_.load(std::memory_order_acquire) - read;
+
+    return split<T const>(read, used);
+  }
+
+  /* Remove count elements seen through readable(). */
+  void consume(std::size_t count) noexcept
+  {
+    std::size_t const read = read_.load(std::memory_order_relaxed);
+
+    assert(count <= size());
+
+    read_.store(read + count, std::memory_order_release);
+  }
+
+  /* The free elements, as one run up to the end of the storage and one from
+     the start of it. */
+  std::array<span<T>, 2> writable() noexcept
+  {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "views need trivially copyable elements");
+
+    std::size_t const write = write_.load(std::memory_order_relaxed);
+    std::size_t const read  = read_.load(std::memory_order_acquire);
+
+    return split<T>(write, N - (write - read));
+  }
+
+  /* Add count elements written through writable(). */
+  void commit(std::size_t count) noexcept
+  {
+    std::size_t const write = write_.load(std::memory_order_relaxed);
+
+    assert(count <= available());
+
+    write_.store(write + count, std::memory_order_release);
+  }
+
+private:
+  T *slot(std::size_t cursor) noexcept
+  {
+    return std::launder(reinterpret_cast<T *>(storage_) + (cursor & mask));
+  }
+
+  T const *slot(std::size_t cursor) const noexcept
+  {
+    return std::launder(reinterpret_cast<T const *>(storage_) +
+                        (cursor & mask));
+  }
+
+  template <typename U>
+  std::array<span<U>, 2> split(std::size_t cursor,
+                               std::size_t count) const noexcept
+  {
+    std::size_t const position = cursor & mask;
+    std::size_t const to_edge  = N - position;
+    U * const         base     = const_cast<U *>(
+      reinterpret_cast<T const *>(storage_));
+
+    if (count <= to_edge) {
+      return {{ span<U>(base + position, count), span<U>(base, 0) }};
+    }
+
+    return {{ span<U>(base + position, to_edge),
+              span<U>(base, count - to_edge) }};
+  }
+
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> write_{0};
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> read_{0};
+  alignas(T) unsigned char storage_[N * sizeof(T)];
+};
+
+} // namespace fifo
+
+#endif /* FIFO_HPP */
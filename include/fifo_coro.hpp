@@ -0,0 +1,289 @@
+/* Fifo Coroutines
+ *
+ * C++20 coroutine support for fifo::ring. fifo::async_ring<T, N> wraps a ring
+ * and adds awaitables, so that a coroutine can wait for data or space instead
+ * of polling:
+ *
+ *   fifo::task consumer(fifo::async_ring<message, 64> &ring)
+ *   {
+ *     for (;;) {
+ *       co_await ring.readable();
+ *       handle(*ring.pop());
+ *     }
+ *   }
+ *
+ * co_await readable(n) completes once at least n elements can be popped, and
+ * writable(n) once at least n can be pushed. Pushes and pops through the
+ * async_ring hand the coroutines whose condition they fulfil to a scheduler,
+ * which resumes them in order from its run loop rather than from within the
+ * push or pop.
+ *
+ * fifo::scheduler is a minimal single threaded run queue, enough for tests and
+ * simple programs. An async_ring and its scheduler must only be used from the
+ * thread running the scheduler, and a ring must not be used once its scheduler
+ * has been destroyed. With several consumers, a coroutine should check the
+ * ring again after it has been resumed, since another one may have run first.
+ */
+
+#ifndef FIFO_CORO_HPP
+#define FIFO_CORO_HPP 1
+
+/* Includes ----------------------------------------------------------------- */
+
+#include <fifo.hpp>
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <vector>
+
+
+namespace fifo {
+
+/* Task --------------------------------------------------------------------- */
+
+/* Coroutine started by a scheduler. A task does not run until it is spawned,
+   and its frame is destroyed by the scheduler when it returns. */
+class task {
+public:
+  struct promise_type {
+    task get_return_object() noexcept
+    {
+      return task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+
+  task(task &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+  task(task const &) = delete;
+  task &operator=(task const &) = delete;
+
+  ~task()
+  {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  /* Give up ownership of the coroutine frame. */
+  std::coroutine_handle<> release() noexcept
+  {
+    return std::exchange(handle_, {});
+  }
+
+private:
+  explicit task(std::coroutine_handle<promise_type> handle) noexcept
+    : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+
+/* Scheduler ---------------------------------------------------------------- */
+
+class scheduler {
+public:
+  scheduler() = default;
+  scheduler(scheduler const &) = delete;
+  scheduler &operator=(scheduler const &) = delete;
+
+  /* Destroys the tasks that have not finished, e.g. those still waiting. */
+  ~scheduler()
+  {
+    for (std::coroutine_handle<> handle : tasks_) {
+      handle.destroy();
+    }
+  }
+
+  /* Take over a task and queue it to run for the first time. */
+  void spawn(task &&t)
+  {
+    std::coroutine_handle<> const handle = t.release();
+
+    tasks_.push_back(handle);
+    post(handle);
+  }
+
+  /* Queue a suspended coroutine to be resumed. */
+  void post(std::coroutine_handle<> handle) { ready_.push_back(handle); }
+
+  /* Resume the next queued coroutine. Returns false if there was none. */
+  bool run_one()
+  {
+    if (ready_.empty()) {
+      return false;
+    }
+
+    std::coroutine_handle<> const handle = ready_.front();
+
+    ready_.pop_front();
+    handle.resume();
+
+    if (handle.done()) {
+      std::erase(tasks_, handle);
+      handle.destroy();
+    }
+
+    return true;
+  }
+
+  /* Resume coroutines until none is ready. Returns the number resumed. */
+  std::size_t run()
+  {
+    std::size_t count = 0;
+
+    while (run_one()) {
+      count ++;
+    }
+
+    return count;
+  }
+
+  /* Returns the number of tasks that have not finished. */
+  std::size_t pending() const noexcept { return tasks_.size(); }
+
+private:
+  std::deque<std::coroutine_handle<>> ready_;
+  std::vector<std::coroutine_handle<>> tasks_;
+};
+
+
+/* Async Ring --------------------------------------------------------------- */
+
+template <typename T, std::size_t N>
+class async_ring {
+  /* A suspended coroutine waiting for count elements or free slots. The
+     awaiter lives in the coroutine frame, so waiting allocates nothing. */
+  struct waiter {
+    async_ring             *ring;
+    std::size_t             count;
+    waiter                **list;
+    waiter                 *next   = nullptr;
+    std::coroutine_handle<> handle = {};
+  };
+
+  struct readable_awaiter : waiter {
+    bool await_ready() const noexcept
+    {
+      return this->ring->ring_.size() >= this->count;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) noexcept
+    {
+      this->ring->wait(this, handle);
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+  struct writable_awaiter : waiter {
+    bool await_ready() const noexcept
+    {
+      return this->ring->ring_.available() >= this->count;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) noexcept
+    {
+      this->ring->wait(this, handle);
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+public:
+  explicit async_ring(scheduler &sched) noexcept : scheduler_(sched) {}
+  async_ring(async_ring const &) = delete;
+  async_ring &operator=(async_ring const &) = delete;
+
+  static constexpr std::size_t capacity() noexcept { return N; }
+
+  std::size_t size() const noexcept { return ring_.size(); }
+  std::size_t available() const noexcept { return ring_.available(); }
+  bool empty() const noexcept { return ring_.empty(); }
+  bool full() const noexcept { return ring_.full(); }
+
+  /* Awaitable that completes once count elements can be popped. */
+  readable_awaiter readable(std::size_t count = 1) noexcept
+  {
+    assert(count > 0 && count <= N);
+
+    return readable_awaiter{{ this, count, &readers_ }};
+  }
+
+  /* Awaitable that completes once count elements can be pushed. */
+  writable_awaiter writable(std::size_t count = 1) noexcept
+  {
+    assert(count > 0 && count <= N);
+
+    return writable_awaiter{{ this, count, &writers_ }};
+  }
+
+  template <typename... Args>
+  bool emplace(Args &&... args)
+  {
+    if (!ring_.emplace(std::forward<Args>(args)...)) {
+      return false;
+    }
+
+    wake(&readers_, ring_.size());
+
+    return true;
+  }
+
+  bool push(T const &value) { return emplace(value); }
+  bool push(T &&value) { return emplace(std::move(value)); }
+
+  std::optional<T> pop()
+  {
+    std::optional<T> value = ring_.pop();
+
+    if (value) {
+      wake(&writers_, ring_.available());
+    }
+
+    return value;
+  }
+
+private:
+  /* Append the waiter to its list, so that waiters are woken in order. */
+  void wait(waiter *w, std::coroutine_handle<> handle) noexcept
+  {
+    waiter **list = w->list;
+
+    while (*list != nullptr) {
+      list = &(*list)->next;
+    }
+
+    w->handle = handle;
+    *list     = w;
+  }
+
+  /* Hand every waiter of the list that asked for at most ready to the
+     scheduler. */
+  void wake(waiter **list, std::size_t ready)
+  {
+    while (*list != nullptr) {
+      waiter * const w = *list;
+
+      if (w->count <= ready) {
+        *list = w->next;
+        scheduler_.post(w->handle);
+      } else {
+        list = &w->next;
+      }
+    }
+  }
+
+  scheduler   &scheduler_;
+  ring<T, N>   ring_;
+  waiter      *readers_ = nullptr;
+  waiter      *writers_ = nullptr;
+};
+
+} // namespace fifo
+
+#endif /* FIFO_CORO_HPP */
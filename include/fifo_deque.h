@@ -0,0 +1,80 @@
+/* Fifo Deque
+ *
+ * Lock free work stealing deque of pointers, after D. Chase and Y. Lev, in the
+ * C11 formulation of N. M. Lê et al. One owner thread pushes and pops at the
+ * bottom, last in first out, while any number of thief threads steal from the
+ * top, first in first out. The owner only synchronizes with thieves when the
+ * deque is about to run empty.
+ *
+ * Like the fifos the slots are a ring with a power of 2 size, indexed by
+ * masking free running cursors. When the owner pushes onto a full deque the
+ * ring is replaced by one of twice the size, like fifo__resize grows a fifo.
+ * Thieves may still be reading the old ring, so it is kept until the deque is
+ * destroyed, which costs at most as much memory again as the largest ring.
+ */
+
+#ifndef FIFO_DEQUE_H
+#define FIFO_DEQUE_H 1
+
+/* Includes ----------------------------------------------------------------- */
+
+#include <compiler.h>
+#include <fifo.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+
+#define FIFO_DEQUE__SIZE_MIN                      2
+
+
+/* Data Types --------------------------------------------------------------- */
+
+/* Ring of slots, followed by the ring it replaced, if any. */
+typedef struct fifo_deque__ring {
+  size_t                   mask;
+  struct fifo_deque__ring *retired;
+  _Atomic(void *)          slots[];
+} fifo_deque__ring_t;
+
+/* Work stealing deque.
+ * top is advanced by thieves and bottom by the owner, so they are kept on
+ * separate cache lines.
+ */
+typedef struct fifo_deque {
+  ALIGNED(CACHE_LINE_SIZE) _Atomic(size_t) top;
+  ALIGNED(CACHE_LINE_SIZE) _Atomic(size_t) bottom;
+  _Atomic(fifo_deque__ring_t *)            ring;
+} fifo_deque_t;
+
+
+/* Public Functions --------------------------------------------------------- */
+
+fifo__result_t
+  fifo_deque__ctor(fifo_deque_t *deque, size_t size)
+  NONNULL;
+
+void
+  fifo_deque__dtor(fifo_deque_t *deque)
+  NONNULL;
+
+size_t
+  fifo_deque__size(fifo_deque_t const *deque)
+  NONNULL;
+
+size_t
+  fifo_deque__used(fifo_deque_t const *deque)
+  NONNULL;
+
+fifo__result_t
+  fifo_deque__push(fifo_deque_t *deque, void *task)
+  NONNULL_ARGS(1);
+
+bool_t
+  fifo_deque__pop(fifo_deque_t *deque, void **task)
+  NONNULL;
+
+bool_t
+  fifo_deque__steal(fifo_deque_t *deque, void **task)
+  NONNULL;
+
+#endif /* FIFO_DEQUE_H */
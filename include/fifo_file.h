@@ -0,0 +1,131 @@
+/* Fifo File
+ *
+ * Byte fifo that lives in a memory mapped file, so that its contents survive
+ * a restart of the process, or of the machine. The file holds a header with
+ * the size and the cursors, followed by the data, which starts on a page of
+ * its own.
+ *
+ *   fifo_file__open(&fifo, "/var/spool/collector.fifo", 1 << 20, 64 * 1024);
+ *   fifo_file__write(&fifo, record, len);
+ *   fifo_file__read(&fifo, dest, sizeof(dest));
+ *   fifo_file__close(&fifo);
+ *
+ * Writes and reads work on the mapping at memory speed and only move cursors
+ * in the handle. Every so often the cursors are committed: the new data is
+ * flushed to the file with msync, and then the cursors are stored in the
+ * header, which is flushed as well. On open the fifo is recovered as of the
+ * last commit, so data written after it is lost, and data read after it is
+ * read again. Space is only reused once the read that freed it is committed,
+ * so that a crash never leaves the recovered cursors pointing at overwritten
+ * data.
+ *
+ * The header holds two commit records, which are written alternately. Each
+ * carries a sequence number and a checksum, so a record torn by a crash is
+ * detected and the other one is used.
+ *
+ * The sync argument of fifo_file__open batches the msync calls: a commit
+ * happens by itself once that many bytes have been written or read since the
+ * last one. 0 commits after every write and read, larger values trade
+ * durability for speed, and fifo_file__sync commits at any time.
+ *
+ * The file is locked while it is open, so only one handle at a time can use
+ * it. Not thread safe. Unix only.
+ */
+
+#ifndef FIFO_FILE_H
+#define FIFO_FILE_H 1
+
+/* Includes ----------------------------------------------------------------- */
+
+#include <compiler.h>
+#include <fifo.h>
+
+#ifdef __unix__
+
+/* Marks a completely initialized header, and its layout version. */
+#define FIFO_FILE__MAGIC                          0x46494646
+
+
+/* Data Types --------------------------------------------------------------- */
+
+/* Commit record.
+ * The checksum is the CRC32C of the fields before it.
+ */
+typedef struct fifo_file__commit {
+  uint64_t sequence;
+  uint64_t write;
+  uint64_t read;
+  uint32_t checksum;
+  uint32_t reserved;
+} fifo_file__commit_t;
+
+/* Header at the start of the file.
+ * Only fixed width types are used so that the file can be read by 32 and 64
+ * bit processes alike. The data starts offset bytes after the header.
+ */
+typedef struct fifo_file__header {
+  uint32_t            magic;
+  uint32_t            reserved;
+  uint64_t            size;
+  uint64_t            offset;
+  fifo_file__commit_t commit[2];
+} fifo_file__header_t;
+
+/* Handle on an open file.
+ * write and read are the current cursors, committed_write and committed_read
+ * those of the last commit, which has the given sequence number.
+ */
+typedef struct fifo_file {
+  fifo_file__header_t *header;
+  uint8_t             *buffer;
+  size_t               mask;
+  size_t               mapped;
+  size_t               sync;
+  int                  fd;
+
+  uint64_t             write;
+  uint64_t             read;
+  uint64_t             committed_write;
+  uint64_t             committed_read;
+  uint64_t             sequence;
+} fifo_file_t;
+
+
+/* Public Functions --------------------------------------------------------- */
+
+fifo__result_t
+  fifo_file__open(fifo_file_t *fifo, char const *path, size_t size,
+                  size_t sync)
+  NONNULL;
+
+fifo__result_t
+  fifo_file__close(fifo_file_t *fifo)
+  NONNULL;
+
+fifo__result_t
+  fifo_file__sync(fifo_file_t *fifo)
+  NONNULL;
+
+size_t
+  fifo_file__size(fifo_file_t const *fifo)
+  NONNULL;
+
+size_t
+  fifo_file__used(fifo_file_t const *fifo)
+  NONNULL;
+
+size_t
+  fifo_file__available(fifo_file_t const *fifo)
+  NONNULL;
+
+size_t
+  fifo_file__write(fifo_file_t *fifo, void const *src, size_t len)
+  NONNULL;
+
+size_t
+  fifo_file__read(fifo_file_t *fifo, void *dest, size_t len)
+  NONNULL;
+
+#endif /* __unix__ */
+
+#endif /* FIFO_FILE_H */
@@ -0,0 +1,41 @@
+/* Fifo Mirror
+ *
+ * Storage provider for the wide fifos that maps the same memory twice, back to
+ * back, so that the buffer appears to continue past its edge with its own
+ * start. A fifo constructed on it with fifo16__ctor_mirrored, fifo32__ctor_
+ * mirrored or fifosz__ctor_mirrored never has to split data at the edge.
+ *
+ * Linux only, the memory is backed by a memfd.
+ */
+
+#ifndef FIFO_MIRROR_H
+#define FIFO_MIRROR_H 1
+
+/* Includes ----------------------------------------------------------------- */
+
+#include <compiler.h>
+#include <fifo.h>
+
+/* Largest size, the buffer is mapped twice in a row. */
+#define FIFO_MIRROR__SIZE_MAX                     ((SIZE_MAX >> 2) + 1)
+
+
+/* Data Types --------------------------------------------------------------- */
+
+typedef struct fifo_mirror {
+  uint8_t *buffer;
+  size_t   size;
+} fifo_mirror_t;
+
+
+/* Public Functions --------------------------------------------------------- */
+
+fifo__result_t
+  fifo_mirror__ctor(fifo_mirror_t *mirror, size_t size)
+  NONNULL;
+
+void
+  fifo_mirror__dtor(fifo_mirror_t *mirror)
+  NONNULL;
+
+#endif /* FIFO_MIRROR_H */
@@ -0,0 +1,86 @@
+/* Fifo MPMC
+ *
+ * Bounded queue of fixed size elements that any number of producer and
+ * consumer threads can use at the same time without locks. Each slot carries
+ * a sequence number that tells whether it is ready to be written or read in
+ * the current lap, and threads claim slots by advancing the enqueue or dequeue
+ * position with compare and swap (D. Vyukov's bounded MPMC queue).
+ *
+ * The number of slots must be a power of 2, other sizes are rounded down. The
+ * caller provides the memory for the slots, FIFO_MPMC__BUFFER_SIZE gives the
+ * number of bytes needed.
+ */
+
+#ifndef FIFO_MPMC_H
+#define FIFO_MPMC_H 1
+
+/* Includes ----------------------------------------------------------------- */
+
+#include <compiler.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+
+#define FIFO_MPMC__SIZE_MIN                       2
+
+
+/* Data Types --------------------------------------------------------------- */
+
+/* Slot header, followed by the element itself.
+ */
+typedef struct fifo_mpmc__slot {
+  _Atomic(size_t) sequence;
+} fifo_mpmc__slot_t;
+
+/* MPMC queue.
+ * The enqueue and dequeue positions are kept on separate cache lines since they
+ * are written by different threads.
+ */
+typedef struct fifo_mpmc {
+  uint8_t * const buffer;
+  size_t          mask;
+  size_t          element_size;
+  size_t          slot_size;
+
+  ALIGNED(CACHE_LINE_SIZE) _Atomic(size_t) enqueue;
+  ALIGNED(CACHE_LINE_SIZE) _Atomic(size_t) dequeue;
+} fifo_mpmc_t;
+
+
+/* Macros ------------------------------------------------------------------- */
+
+/* Size of one slot holding an element of the given size. */
+#define FIFO_MPMC__SLOT_SIZE(element_size)                  \
+  ((sizeof(fifo_mpmc__slot_t) + (element_size) +            \
+    sizeof(fifo_mpmc__slot_t) - 1) &                        \
+   ~(sizeof(fifo_mpmc__slot_t) - 1))
+
+/* Number of bytes needed for size slots of the given element size. */
+#define FIFO_MPMC__BUFFER_SIZE(size, element_size)          \
+  ((size) * FIFO_MPMC__SLOT_SIZE(element_size))
+
+
+/* Public Functions --------------------------------------------------------- */
+
+void
+  fifo_mpmc__ctor(fifo_mpmc_t *fifo, void *buffer, size_t size,
+                  size_t element_size)
+  NONNULL;
+
+size_t
+  fifo_mpmc__size(fifo_mpmc_t const *fifo)
+  NONNULL;
+
+size_t
+  fifo_mpmc__used(fifo_mpmc_t const *fifo)
+  NONNULL;
+
+bool_t
+  fifo_mpmc__write(fifo_mpmc_t *fifo, void const *src)
+  NONNULL;
+
+bool_t
+  fifo_mpmc__read(fifo_mpmc_t *fifo, void *dest)
+  NONNULL;
+
+#endif /* FIFO_MPMC_H */
@@ -0,0 +1,84 @@
+/* Fifo Priority
+ *
+ * Message queue with up to FIFO_PRIO__LANES_MAX lanes under one handle, so
+ * that urgent messages do not wait behind bulk data. Each lane is a fifo32_t
+ * holding messages written by fifo32__push_msg, on a buffer of its own. Lane 0
+ * has the highest priority.
+ *
+ * A bitmap marks the lanes that hold messages, so the next lane to read from
+ * is found with a single count trailing zeros instruction, however many lanes
+ * there are. Two policies decide which lane that is:
+ *
+ *   FIFO_PRIO__STRICT    always the highest priority lane with a message, so
+ *                        lower lanes starve while higher ones are busy
+ *   FIFO_PRIO__WEIGHTED  weighted round robin: in every round each lane may
+ *                        deliver as many messages as its weight, highest
+ *                        priority first, and a new round starts once no lane
+ *                        with messages has any weight left
+ *
+ * Not thread safe.
+ */
+
+#ifndef FIFO_PRIO_H
+#define FIFO_PRIO_H 1
+
+/* Includes ----------------------------------------------------------------- */
+
+#include <compiler.h>
+#include <fifo.h>
+
+
+#define FIFO_PRIO__LANES_MAX                      32
+
+
+/* Data Types --------------------------------------------------------------- */
+
+typedef enum {
+  FIFO_PRIO__STRICT,
+  FIFO_PRIO__WEIGHTED,
+} fifo_prio__policy_t;
+
+typedef struct fifo_prio__lane {
+  fifo32_t fifo;
+  uint32_t weight;
+  uint32_t credit;
+} fifo_prio__lane_t;
+
+/* Priority fifo.
+ * Bit i of used is set while lane i holds a message, and bit i of credited
+ * while it may still deliver messages in the current weighted round.
+ */
+typedef struct fifo_prio {
+  fifo_prio__policy_t policy;
+  uint32_t            lanes;
+  uint32_t            used;
+  uint32_t            credited;
+  fifo_prio__lane_t   lane[FIFO_PRIO__LANES_MAX];
+} fifo_prio_t;
+
+
+/* Public Functions --------------------------------------------------------- */
+
+void
+  fifo_prio__ctor(fifo_prio_t *prio, fifo_prio__policy_t policy)
+  NONNULL;
+
+fifo__result_t
+  fifo_prio__lane_ctor(fifo_prio_t *prio, size_t lane, void *buffer,
+                       size_t size, uint32_t weight)
+  NONNULL;
+
+bool_t
+  fifo_prio__is_empty(fifo_prio_t const *prio)
+  NONNULL;
+
+fifo__result_t
+  fifo_prio__push(fifo_prio_t *prio, size_t lane, void const *src, size_t len)
+  NONNULL;
+
+fifo__result_t
+  fifo_prio__pop(fifo_prio_t *prio, void *dest, size_t size, size_t *len,
+                 size_t *lane)
+  NONNULL;
+
+#endif /* FIFO_PRIO_H */
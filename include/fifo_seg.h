@@ -0,0 +1,113 @@
+/* Fifo Segmented
+ *
+ * Unbounded byte fifo made of a linked list of fixed size segments. The fifo
+ * grows by appending a segment when the last one is full and shrinks by
+ * dropping the first one when it has been read, so growing never moves the
+ * data that is already queued.
+ *
+ * Segments come from a pool that keeps the released ones on a free list, and
+ * only calls malloc when the list is empty. Once the pool holds as many
+ * segments as the fifos need at their peak, writing and reading no longer
+ * allocate at all. fifo_seg__pool_reserve allocates segments up front, and a
+ * limit caps the number of segments the pool hands out.
+ *
+ *   fifo_seg__pool_t pool;
+ *   fifo_seg_t       fifo;
+ *
+ *   fifo_seg__pool_ctor(&pool, 4096, 0);
+ *   fifo_seg__ctor(&fifo, &pool);
+ *
+ *   fifo_seg__write(&fifo, data, len);   // => len, unless the pool ran out
+ *
+ * Neither the pool nor the fifos are thread safe. A pool may serve any number
+ * of fifos of the same thread.
+ */
+
+#ifndef FIFO_SEG_H
+#define FIFO_SEG_H 1
+
+/* Includes ----------------------------------------------------------------- */
+
+#include <compiler.h>
+#include <fifo.h>
+#include <stddef.h>
+
+
+/* Data Types --------------------------------------------------------------- */
+
+/* Segment header, followed by segment_size bytes of data. */
+typedef struct fifo_seg__segment {
+  struct fifo_seg__segment *next;
+} fifo_seg__segment_t;
+
+/* Pool of segments of one size.
+ * allocated counts every segment obtained from malloc, including those in use
+ * by fifos. A limit of 0 means no limit.
+ */
+typedef struct fifo_seg__pool {
+  fifo_seg__segment_t *free;
+  size_t               segment_size;
+  size_t               limit;
+  size_t               allocated;
+  size_t               available;
+} fifo_seg__pool_t;
+
+/* Segmented fifo.
+ * Data is read from head at offset read and written to tail at offset write.
+ * An empty fifo keeps its last segment, so that a fifo that is drained and
+ * refilled in turn does not go back to the pool every time.
+ */
+typedef struct fifo_seg {
+  fifo_seg__pool_t    *pool;
+  fifo_seg__segment_t *head;
+  fifo_seg__segment_t *tail;
+  size_t               read;
+  size_t               write;
+  size_t               used;
+} fifo_seg_t;
+
+
+/* Public Functions --------------------------------------------------------- */
+
+void
+  fifo_seg__pool_ctor(fifo_seg__pool_t *pool, size_t segment_size,
+                      size_t limit)
+  NONNULL;
+
+fifo__result_t
+  fifo_seg__pool_reserve(fifo_seg__pool_t *pool, size_t count)
+  NONNULL;
+
+void
+  fifo_seg__pool_dtor(fifo_seg__pool_t *pool)
+  NONNULL;
+
+void
+  fifo_seg__ctor(fifo_seg_t *fifo, fifo_seg__pool_t *pool)
+  NONNULL;
+
+void
+  fifo_seg__dtor(fifo_seg_t *fifo)
+  NONNULL;
+
+size_t
+  fifo_seg__used(fifo_seg_t const *fifo)
+  NONNULL;
+
+bool_t
+  fifo_seg__is_empty(fifo_seg_t const *fifo)
+  NONNULL;
+
+size_t
+  fifo_seg__write(fifo_seg_t *fifo, void const *src, size_t len)
+  NONNULL;
+
+size_t
+  fifo_seg__read(fifo_seg_t *fifo, void *dest, size_t len)
+  NONNULL;
+
+void
+  fifo_seg__flush(fifo_seg_t *fifo)
+  NONNULL;
+
+#endif /* FIFO_SEG_H */
@@ -0,0 +1,109 @@
+/* Fifo Shared Memory
+ *
+ * Byte fifo that lives entirely in a POSIX shared memory object, so that two
+ * processes can exchange data through it without sockets or copies by the
+ * kernel. The object holds a header with the size and the cursors, followed by
+ * the data. The header locates the data by its offset rather than by address,
+ * so every process may map the object wherever it likes.
+ *
+ *   Process A                               Process B
+ *
+ *   fifo_shm__create(&fifo, "/link", 4096); fifo_shm__attach(&fifo, "/link");
+ *   fifo_shm__write(&fifo, "Hello", 5);     fifo_shm__read(&fifo, dest, 5);
+ *   fifo_shm__detach(&fifo);                fifo_shm__detach(&fifo);
+ *   fifo_shm__unlink("/link");
+ *
+ * One process writes and one reads, like a fifo built with FIFO__SPSC. The
+ * cursors are always atomic and free running, independent of that define, and
+ * are kept on separate cache lines. Both processes must trust each other,
+ * since either can overwrite the header. Unix only.
+ */
+
+#ifndef FIFO_SHM_H
+#define FIFO_SHM_H 1
+
+/* Includes ----------------------------------------------------------------- */
+
+#include <compiler.h>
+#include <fifo.h>
+#include <stdatomic.h>
+
+#ifdef __unix__
+
+/* Marks a completely initialized header, and its layout version. */
+#define FIFO_SHM__MAGIC                           0x46494631
+
+
+/* Data Types --------------------------------------------------------------- */
+
+/* Header at the start of the shared memory object.
+ * Only fixed width types are used so that 32 and 64 bit processes agree on the
+ * layout. The data starts offset bytes after the header.
+ */
+typedef struct fifo_shm__header {
+  _Atomic(uint32_t) magic;
+  uint32_t          reserved;
+  uint64_t          size;
+  uint64_t          offset;
+
+  ALIGNED(CACHE_LINE_SIZE) _Atomic(uint64_t) write;
+  ALIGNED(CACHE_LINE_SIZE) _Atomic(uint64_t) read;
+} fifo_shm__header_t;
+
+/* Handle of one process on a shared fifo.
+ * buffer is where the data is mapped in this process. The cached cursors are
+ * private copies of the cursor of the other side, which are only reloaded when
+ * they do not promise enough data or space.
+ */
+typedef struct fifo_shm {
+  fifo_shm__header_t *header;
+  uint8_t            *buffer;
+  size_t              mask;
+  size_t              mapped;
+
+  uint64_t            read_cache;
+  uint64_t            write_cache;
+} fifo_shm_t;
+
+
+/* Public Functions --------------------------------------------------------- */
+
+fifo__result_t
+  fifo_shm__create(fifo_shm_t *fifo, char const *name, size_t size)
+  NONNULL;
+
+fifo__result_t
+  fifo_shm__attach(fifo_shm_t *fifo, char const *name)
+  NONNULL;
+
+void
+  fifo_shm__detach(fifo_shm_t *fifo)
+  NONNULL;
+
+fifo__result_t
+  fifo_shm__unlink(char const *name)
+  NONNULL;
+
+size_t
+  fifo_shm__size(fifo_shm_t const *fifo)
+  NONNULL;
+
+size_t
+  fifo_shm__used(fifo_shm_t const *fifo)
+  NONNULL;
+
+size_t
+  fifo_shm__available(fifo_shm_t const *fifo)
+  NONNULL;
+
+size_t
+  fifo_shm__write(fifo_shm_t *fifo, void const *src, size_t len)
+  NONNULL;
+
+size_t
+  fifo_shm__read(fifo_shm_t *fifo, void *dest, size_t len)
+  NONNULL;
+
+#endif /* __unix__ */
+
+#endif /* FIFO_SHM_H */
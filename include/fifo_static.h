@@ -0,0 +1,144 @@
+/* Fifo Static
+ *
+ * Generator for byte fifos whose size is known at compile time.
+ * FIFO_DEFINE_STATIC(name, size) defines the type name_t, which embeds a buffer
+ * of size bytes, and static inline functions name__write, name__read etc. The
+ * size and mask are constants in every function, so calls can be inlined
+ * completely and copies of a constant length unrolled.
+ *
+ *   FIFO_DEFINE_STATIC(uart_fifo, 64)
+ *
+ *   static uart_fifo_t fifo;
+ *
+ *   uart_fifo__write(&fifo, "Hello", 5);
+ *
+ * The size must be a power of 2 of at least FIFO__SIZE_MIN. A zero initialized
+ * fifo is empty, so static fifos need no constructor call. Like the fifos of
+ * fifo_typed.h the cursors are free running, and FIFO__SPSC makes them safe for
+ * one producer and one consumer thread.
+ */
+
+#ifndef FIFO_STATIC_H
+#define FIFO_STATIC_H 1
+
+/* Includes ----------------------------------------------------------------- */
+
+#include <compiler.h>
+#include <fifo.h>
+#include <fifo_typed.h>
+
+
+/* Macros ------------------------------------------------------------------- */
+
+/* Define a fifo of the given constant size, see above. */
+#define FIFO_DEFINE_STATIC(name, size)                                         \
+                                                                               \
+_Static_assert((size) >= FIFO__SIZE_MIN && ((size) & ((size) - 1)) == 0,      \
+               #name " size must be a power of 2");                            \
+                                                                               \
+typedef struct name {                                                          \
+  FIFO_TYPED__CURSOR read;                                                     \
+  FIFO_TYPED__CURSOR write;                                                    \
+  uint8_t            buffer[size];                                             \
+} name ## _t;                                                                  \
+                                                                               \
+/* Empty the fifo. Not needed for zero initialized fifos. */                   \
+static inline void                                                             \
+name ## __ctor(name ## _t *fifo)                                               \
+{                                                                              \
+  FIFO_TYPED__STORE(fifo, read,  0, relaxed);                                  \
+  FIFO_TYPED__STORE(fifo, write, 0, relaxed);                                  \
+}                                                                              \
+                                                                               \
+static inline size_t                                                           \
+name ## __size(name ## _t const *fifo)                                         \
+{                                                                              \
+  return (size);                                                               \
+}                                                                              \
+                                                                               \
+static inline size_t                                                           \
+name ## __used(name ## _t const *fifo)                                         \
+{                                                                              \
+  size_t const read = FIFO_TYPED__LOAD(fifo, read, acquire);                   \
+                                                                               \
+  return FIFO_TYPED__LOAD(fifo, write, acquire) - read;                        \
+}                                                                              \
+                                                                               \
+static inline size_t                                                           \
+name ## __available(name ## _t const *fifo)                                    \
+{                                                                              \
+  return (size) - name ## __used(fifo);                                        \
+}                                                                              \
+                                                                               \
+static inline bool_t                                                           \
+name ## __is_empty(name ## _t const *fifo)                                     \
+{                                                                              \
+  return name ## __used(fifo) == 0;                                            \
+}                                                                              \
+                                                                               \
+static inline bool_t                                                           \
+name ## __is_full(name ## _t const *fifo)                                      \
+{                                                                              \
+  return name ## __used(fifo) == (size);                                       \
+}                                                                              \
+                                                                               \
+/* Write up to len bytes. Returns the number of bytes written. */              \
+static inline size_t                                                           \
+name ## __write(name ## _t *fifo, void const *src, size_t len)                 \
+{                                                                              \
+  size_t const write    = FIFO_TYPED__LOAD(fifo, write, relaxed);              \
+  size_t const position = write & ((size) - 1);                                \
+  size_t const to_edge  = (size) - position;                                   \
+  size_t const available =                                                     \
+    (size) - (write - FIFO_TYPED__LOAD(fifo, read, acquire));                  \
+                                                                               \
+  if (len > available) {                                                       \
+    len = available;                                                           \
+  }                                                                            \
+                                                                               \
+  if (len <= to_edge) {                                                        \
+    memcpy(&fifo->buffer[position], src, len);                                 \
+  } else {                                                                     \
+    memcpy(&fifo->buffer[position], src, to_edge);                             \
+    memcpy(fifo->buffer, (uint8_t const *) src + to_edge, len - to_edge);      \
+  }                                                                            \
+                                                                               \
+  FIFO_TYPED__STORE(fifo, write, write + len, release);                        \
+                                                                               \
+  return len;                                                                  \
+}                                                                              \
+                                                                               \
+/* Read up to len bytes. Returns the number of bytes read. */                  \
+static inline size_t                                                           \
+name ## __read(name ## _t *fifo, void *dest, size_t len)                       \
+{                                                                              \
+  size_t const read     = FIFO_TYPED__LOAD(fifo, read, relaxed);               \
+  size_t const position = read & ((size) - 1);                                 \
+  size_t const to_edge  = (size) - position;                                   \
+  size_t const used     = FIFO_TYPED__LOAD(fifo, write, acquire) - read;       \
+                                                                               \
+  if (len > used) {                                                            \
+    len = used;                                                                \
+  }                                                                            \
+                                                                               \
+  if (len <= to_edge) {                                                        \
+    memcpy(dest, &fifo->buffer[position], len);                                \
+  } else {                                                                     \
+    memcpy(dest, &fifo->buffer[position], to_edge);                            \
+    memcpy((uint8_t *) dest + to_edge, fifo->buffer, len - to_edge);           \
+  }                                                                            \
+                                                                               \
+  FIFO_TYPED__STORE(fifo, read, read + len, release);                          \
+                                                                               \
+  return len;                                                                  \
+}                                                                              \
+                                                                               \
+/* Remove all bytes. In SPSC mode this must be called by the consumer. */      \
+static inline void                                                             \
+name ## __flush(name ## _t *fifo)                                              \
+{                                                                              \
+  FIFO_TYPED__STORE(fifo, read, FIFO_TYPED__LOAD(fifo, write, acquire),        \
+                    release);                                                  \
+}
+
+#endif /* FIFO_STATIC_H */
@@ -0,0 +1,302 @@
+/* Fifo Template
+ *
+ * Declares the fifo data type and its public functions for one index width.
+ * This file is included once per width by fifo.h and must not be included
+ * directly. The following parameters must be defined before inclusion and are
+ * undefined again at the end of the file:
+ *
+ *   FIFO_T__NAME      Name prefix of the type and its functions, e.g. fifo16
+ *                     gives fifo16_t and fifo16__write().
+ *   FIFO_T__INDEX     Unsigned integer type used for the mask and the cursors.
+ *   FIFO_T__CURSOR    Unsigned integer type, wider than FIFO_T__INDEX, used
+ *                     for the free running cursors in SPSC mode.
+ *   FIFO_T__MIRROR    Optional. Defined for widths that can index buffers
+ *                     large enough to be mirrored in virtual memory.
+ */
+
+#ifndef FIFO_T__NAME
+#error "FIFO_T__NAME must be defined before including fifo_template.h"
+#endif
+
+/* Macros ------------------------------------------------------------------- */
+
+#ifndef FIFO_T__FN
+#define FIFO_T__CONCAT_(a, b)                     a ## b
+#define FIFO_T__CONCAT(a, b)                      FIFO_T__CONCAT_(a, b)
+
+/* Expands to the type name, e.g. fifo16_t. */
+#define FIFO_T__TYPE                                        \
+  FIFO_T__CONCAT(FIFO_T__NAME, _t)
+
+/* Expands to the name of a public function, e.g. fifo16__write. */
+#define FIFO_T__FN(name)                                    \
+  FIFO_T__CONCAT(FIFO_T__NAME, __ ## name)
+#endif
+
+
+/* Data Types --------------------------------------------------------------- */
+
+/* Main FIFO data type.
+ * Size: pointer + 3 index words.
+ *
+ * In SPSC mode the cursors are free running and only ever written by their
+ * owning side, the producer for write and the consumer for read. The mask is
+ * only changed by the constructor and resize.
+ * Size: pointer + 1 index word + 2 cursor words.
+ *
+ * With FIFO__CACHE_ALIGNED the producer and consumer state is kept on separate
+ * cache lines, and each side keeps a private copy of the cursor of the other
+ * side which is only refreshed when the copy says the fifo is full or empty.
+ * Size: 3 cache lines.
+ *
+ * With FIFO__WAIT each direction gets a futex word, which is bumped whenever
+ * data or space becomes available while a thread is waiting for it, and a count
+ * of waiting threads.
+ *
+ * With FIFO__NOTIFY each direction gets an eventfd and a flag telling whether
+ * the other side should signal it, see fifo__notify_ctor.
+ *
+ * With FIFO__STATS the producer and consumer each get a set of counters, kept
+ * with the rest of their state.
+ *
+ * Widths that support mirrored buffers carry an extra flag, set by
+ * fifo__ctor_mirrored.
+ */
+typedef struct FIFO_T__NAME {
+  uint8_t * const buffer;
+#ifdef FIFO_T__MIRROR
+  bool_t mirrored;
+#endif
+#if defined(FIFO__SPSC) && defined(FIFO__CACHE_ALIGNED)
+  FIFO_T__INDEX mask;
+
+  /* Producer */
+  ALIGNED(CACHE_LINE_SIZE) _Atomic(FIFO_T__CURSOR) write;
+  FIFO_T__CURSOR read_cache;
+#ifdef FIFO__STATS
+  fifo__producer_stats_t producer_stats;
+#endif
+
+  /* Consumer */
+  ALIGNED(CACHE_LINE_SIZE) _Atomic(FIFO_T__CURSOR) read;
+  FIFO_T__CURSOR write_cache;
+#ifdef FIFO__STATS
+  fifo__consumer_stats_t consumer_stats;
+#endif
+#else
+#if defined(FIFO__SPSC)
+  FIFO_T__INDEX mask;
+  _Atomic(FIFO_T__CURSOR) read;
+  _Atomic(FIFO_T__CURSOR) write;
+#else
+  FIFO_T__INDEX volatile mask;
+  FIFO_T__INDEX volatile read;
+  FIFO_T__INDEX volatile write;
+#endif
+#ifdef FIFO__STATS
+  fifo__producer_stats_t producer_stats;
+  fifo__consumer_stats_t consumer_stats;
+#endif
+#endif
+#ifdef FIFO__WAIT
+#ifdef FIFO__CACHE_ALIGNED
+  ALIGNED(CACHE_LINE_SIZE)
+#endif
+  _Atomic(uint32_t) data_futex;
+  _Atomic(uint32_t) data_waiters;
+  _Atomic(uint32_t) space_futex;
+  _Atomic(uint32_t) space_waiters;
+#endif
+#ifdef FIFO__NOTIFY
+#ifdef FIFO__CACHE_ALIGNED
+  ALIGNED(CACHE_LINE_SIZE)
+#endif
+  int              data_fd;
+  int              space_fd;
+  size_t           space_threshold;
+  _Atomic(uint8_t) data_armed;
+  _Atomic(uint8_t) space_armed;
+#endif
+} FIFO_T__TYPE;
+
+
+/* Public Functions --------------------------------------------------------- */
+
+void
+  FIFO_T__FN(ctor)(FIFO_T__TYPE *fifo, void *buffer, size_t size)
+  NONNULL_ARGS(1);
+
+#ifdef FIFO_T__MIRROR
+void
+  FIFO_T__FN(ctor_mirrored)(FIFO_T__TYPE *fifo, void *buffer, size_t size)
+  NONNULL;
+#endif
+
+fifo__result_t
+  FIFO_T__FN(resize)(FIFO_T__TYPE *fifo, size_t new_size)
+  NONNULL;
+
+void
+  FIFO_T__FN(flush)(FIFO_T__TYPE *fifo)
+  NONNULL;
+
+static inline bool_t
+  FIFO_T__FN(is_full)(FIFO_T__TYPE const *fifo)
+  NONNULL;
+
+bool_t
+  FIFO_T__FN(is_empty)(FIFO_T__TYPE const *fifo)
+  NONNULL;
+
+size_t
+  FIFO_T__FN(size)(FIFO_T__TYPE const *fifo)
+  NONNULL;
+
+size_t
+  FIFO_T__FN(used)(FIFO_T__TYPE const *fifo)
+  NONNULL;
+
+size_t
+  FIFO_T__FN(available)(FIFO_T__TYPE const *fifo)
+  NONNULL;
+
+size_t
+  FIFO_T__FN(write)(FIFO_T__TYPE *fifo, void const *src, size_t len)
+  NONNULL;
+
+size_t
+  FIFO_T__FN(write_force)(FIFO_T__TYPE *fifo, void const *src, size_t len)
+  NONNULL;
+
+size_t
+  FIFO_T__FN(read)(FIFO_T__TYPE *fifo, void *dest, size_t size)
+  NONNULL;
+
+size_t
+  FIFO_T__FN(write_reserve)(FIFO_T__TYPE *fifo, fifo__region_t regions[2])
+  NONNULL;
+
+void
+  FIFO_T__FN(write_commit)(FIFO_T__TYPE *fifo, size_t len)
+  NONNULL;
+
+size_t
+  FIFO_T__FN(read_peek)(FIFO_T__TYPE const *fifo, fifo__region_t regions[2])
+  NONNULL;
+
+void
+  FIFO_T__FN(read_consume)(FIFO_T__TYPE *fifo, size_t len)
+  NONNULL;
+
+fifo__result_t
+  FIFO_T__FN(push_msg)(FIFO_T__TYPE *fifo, void const *src, size_t len)
+  NONNULL;
+
+fifo__result_t
+  FIFO_T__FN(pop_msg)(FIFO_T__TYPE *fifo, void *dest, size_t size,
+                      size_t *len)
+  NONNULL;
+
+fifo__result_t
+  FIFO_T__FN(next_msg_len)(FIFO_T__TYPE const *fifo, size_t *len)
+  NONNULL;
+
+size_t
+  FIFO_T__FN(write_crc)(FIFO_T__TYPE *fifo, void const *src, size_t len,
+                        uint32_t *crc)
+  NONNULL;
+
+size_t
+  FIFO_T__FN(read_crc)(FIFO_T__TYPE *fifo, void *dest, size_t len,
+                       uint32_t *crc)
+  NONNULL;
+
+fifo__result_t
+  FIFO_T__FN(find)(FIFO_T__TYPE const *fifo, uint8_t byte, size_t *offset)
+  NONNULL;
+
+fifo__result_t
+  FIFO_T__FN(read_until)(FIFO_T__TYPE *fifo, void *dest, size_t size,
+                         uint8_t delim, size_t *len)
+  NONNULL;
+
+#ifdef FIFO__STATS
+void
+  FIFO_T__FN(stats)(FIFO_T__TYPE const *fifo, fifo__stats_t *stats)
+  NONNULL;
+#endif
+
+#ifdef __unix__
+size_t
+  FIFO_T__FN(writev)(FIFO_T__TYPE *fifo, struct iovec const *iov, int iovcnt)
+  NONNULL;
+
+size_t
+  FIFO_T__FN(readv)(FIFO_T__TYPE *fifo, struct iovec const *iov, int iovcnt)
+  NONNULL;
+
+fifo__result_t
+  FIFO_T__FN(read_from_fd)(FIFO_T__TYPE *fifo, int fd, size_t *len)
+  NONNULL;
+
+fifo__result_t
+  FIFO_T__FN(write_to_fd)(FIFO_T__TYPE *fifo, int fd, size_t *len)
+  NONNULL;
+#endif
+
+#ifdef FIFO__WAIT
+fifo__result_t
+  FIFO_T__FN(read_wait)(FIFO_T__TYPE *fifo, size_t len, int timeout_ms)
+  NONNULL;
+
+fifo__result_t
+  FIFO_T__FN(write_wait)(FIFO_T__TYPE *fifo, size_t len, int timeout_ms)
+  NONNULL;
+#endif
+
+#ifdef FIFO__NOTIFY
+fifo__result_t
+  FIFO_T__FN(notify_ctor)(FIFO_T__TYPE *fifo, size_t space_threshold)
+  NONNULL;
+
+void
+  FIFO_T__FN(notify_dtor)(FIFO_T__TYPE *fifo)
+  NONNULL;
+
+int
+  FIFO_T__FN(data_fd)(FIFO_T__TYPE const *fifo)
+  NONNULL;
+
+int
+  FIFO_T__FN(space_fd)(FIFO_T__TYPE const *fifo)
+  NONNULL;
+#endif
+
+
+/* Inline Function Definitions ---------------------------------------------- */
+
+/* Is Full
+ *
+ * Returns non-zero if the fifo is full.
+ * The lowest bit of the mask is used to indicate a full buffer. In SPSC mode
+ * the fifo is instead full when the cursors are a whole buffer apart.
+ */
+bool_t
+FIFO_T__FN(is_full)(FIFO_T__TYPE const *fifo)
+{
+#ifdef FIFO__SPSC
+  FIFO_T__CURSOR read =
+    atomic_load_explicit(&fifo->read, memory_order_acquire);
+  FIFO_T__CURSOR write =
+    atomic_load_explicit(&fifo->write, memory_order_acquire);
+
+  return fifo->mask == 0 || (FIFO_T__CURSOR) (write - read) > fifo->mask;
+#else
+  return ~fifo->mask & 0x01; // || FIFO__IS_ZERO_SIZE(fifo);
+#endif
+}
+
+#undef FIFO_T__NAME
+#undef FIFO_T__INDEX
+#undef FIFO_T__CURSOR
+#undef FIFO_T__MIRROR
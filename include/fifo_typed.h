@@ -0,0 +1,199 @@
+/* Fifo Typed
+ *
+ * Generator for fifos of fixed size elements. FIFO_DECLARE(name, type)
+ * declares the type name_t and static inline functions name__push,
+ * name__pop etc. that move whole elements of the given type. Since the element
+ * size is known at compile time the copies are plain assignments that the
+ * compiler can inline.
+ *
+ *   FIFO_DECLARE(sample_fifo, sample_t)
+ *
+ *   sample_t      buffer[32];
+ *   sample_fifo_t fifo;
+ *
+ *   sample_fifo__ctor(&fifo, buffer, 32);
+ *   sample_fifo__push(&fifo, &sample);
+ *
+ * Sizes count elements and must be a power of 2, other sizes are rounded down
+ * like for fifo_t. The cursors are free running and masked when indexing the
+ * buffer, so the full state needs no flag. FIFO__SPSC makes the generated fifos
+ * safe for one producer and one consumer thread, in the same way as fifo_t.
+ */
+
+#ifndef FIFO_TYPED_H
+#define FIFO_TYPED_H 1
+
+/* Includes ----------------------------------------------------------------- */
+
+#include <compiler.h>
+#include <fifo.h>
+
+
+/* Macros ------------------------------------------------------------------- */
+
+#ifdef FIFO__SPSC
+#define FIFO_TYPED__CURSOR                        _Atomic(size_t)
+#define FIFO_TYPED__LOAD(fifo, field, order)                \
+  atomic_load_explicit(&(fifo)->field, memory_order_ ## order)
+#define FIFO_TYPED__STORE(fifo, field, value, order)        \
+  atomic_store_explicit(&(fifo)->field, value, memory_order_ ## order)
+#else
+#define FIFO_TYPED__CURSOR                        size_t volatile
+#define FIFO_TYPED__LOAD(fifo, field, order)                \
+  ((fifo)->field)
+#define FIFO_TYPED__STORE(fifo, field, value, order)        \
+  ((fifo)->field = (value))
+#endif
+
+/* Declare a fifo of elements of the given type, see above. */
+#define FIFO_DECLARE(name, type)                                               \
+                                                                               \
+typedef struct name {                                                          \
+  type * const       buffer;                                                   \
+  size_t             mask;                                                     \
+  FIFO_TYPED__CURSOR read;                                                     \
+  FIFO_TYPED__CURSOR write;                                                    \
+} name ## _t;                                                                  \
+                                                                               \
+/* Initialize the fifo on a buffer of size elements. */                        \
+static inline void                                                             \
+name ## __ctor(name ## _t *fifo, type *buffer, size_t size)                    \
+{                                                                              \
+  assert(buffer != NULL);                                                      \
+  assert(size > 0);                                                            \
+                                                                               \
+  WRITE_CONST(fifo->buffer, type *, buffer);                                   \
+  fifo->mask = fifo__size_to_mask(size);                                       \
+                                                                               \
+  FIFO_TYPED__STORE(fifo, read,  0, relaxed);                                  \
+  FIFO_TYPED__STORE(fifo, write, 0, relaxed);                                  \
+}                                                                              \
+                                                                               \
+/* Returns the number of elements the fifo can hold. */                        \
+static inline size_t                                                           \
+name ## __size(name ## _t const *fifo)                                         \
+{                                                                              \
+  return fifo->mask + 1;                                                       \
+}                                                                              \
+                                                                               \
+/* Returns the number of elements in the fifo. */                              \
+static inline size_t                                                           \
+name ## __used(name ## _t const *fifo)                                         \
+{                                                                              \
+  /* Load read first, write can only have moved further ahead of it */         \
+  size_t const read = FIFO_TYPED__LOAD(fifo, read, acquire);                   \
+                                                                               \
+  return FIFO_TYPED__LOAD(fifo, write, acquire) - read;                        \
+}                                                                              \
+                                                                               \
+/* Returns the number of free elements. */                                     \
+static inline size_t                                                           \
+name ## __available(name ## _t const *fifo)                                    \
+{                                                                              \
+  return name ## __size(fifo) - name ## __used(fifo);                          \
+}                                                                              \
+                                                                               \
+static inline bool_t                                                           \
+name ## __is_empty(name ## _t const *fifo)                                     \
+{                                                                              \
+  return name ## __used(fifo) == 0;                                            \
+}                                                                              \
+                                                                               \
+static inline bool_t                                                           \
+name ## __is_full(name ## _t const *fifo)                                      \
+{                                                                              \
+  return name ## __used(fifo) > fifo->mask;                                    \
+}                                                                              \
+                                                                               \
+/* Push one element. Returns non-zero if there was room for it. */             \
+static inline bool_t                                                           \
+name ## __push(name ## _t *fifo, type const *element)                          \
+{                                                                              \
+  size_t const write = FIFO_TYPED__LOAD(fifo, write, relaxed);                 \
+                                                                               \
+  if (write - FIFO_TYPED__LOAD(fifo, read, acquire) > fifo->mask) {            \
+    return 0;                                                                  \
+  }                                                                            \
+                                                                               \
+  fifo->buffer[write & fifo->mask] = *element;                                 \
+  FIFO_TYPED__STORE(fifo, write, write + 1, release);                          \
+                                                                               \
+  return 1;                                                                    \
+}                                                                              \
+                                                                               \
+/* Pop one element. Returns non-zero if there was one. */                      \
+static inline bool_t                                                           \
+name ## __pop(name ## _t *fifo, type *element)                                 \
+{                                                                              \
+  size_t const read = FIFO_TYPED__LOAD(fifo, read, relaxed);                   \
+                                                                               \
+  if (FIFO_TYPED__LOAD(fifo, write, acquire) == read) {                        \
+    return 0;                                                                  \
+  }                                                                            \
+                                                                               \
+  *element = fifo->buffer[read & fifo->mask];                                  \
+  FIFO_TYPED__STORE(fifo, read, read + 1, release);                            \
+                                                                               \
+  return 1;                                                                    \
+}                                                                              \
+                                                                               \
+/* Push up to count elements. Returns the number of elements pushed. */        \
+static inline size_t                                                           \
+name ## __write(name ## _t *fifo, type const *src, size_t count)               \
+{                                                                              \
+  size_t const write    = FIFO_TYPED__LOAD(fifo, write, relaxed);              \
+  size_t const position = write & fifo->mask;                                  \
+  size_t const to_edge  = fifo->mask + 1 - position;                           \
+  size_t const available = fifo->mask + 1                                     \
+    - (write - FIFO_TYPED__LOAD(fifo, read, acquire));                         \
+                                                                               \
+  if (count > available) {                                                     \
+    count = available;                                                         \
+  }                                                                            \
+                                                                               \
+  if (count <= to_edge) {                                                      \
+    memcpy(&fifo->buffer[position], src, count * sizeof(type));               \
+  } else {                                                                     \
+    memcpy(&fifo->buffer[position], src, to_edge * sizeof(type));             \
+    memcpy(fifo->buffer, src + to_edge, (count - to_edge) * sizeof(type));     \
+  }                                                                            \
+                                                                               \
+  FIFO_TYPED__STORE(fifo, write, write + count, release);                      \
+                                                                               \
+  return count;                                                                \
+}                                                                              \
+                                                                               \
+/* Pop up to count elements. Returns the number of elements popped. */         \
+static inline size_t                                                           \
+name ## __read(name ## _t *fifo, type *dest, size_t count)                     \
+{                                                                              \
+  size_t const read     = FIFO_TYPED__LOAD(fifo, read, relaxed);               \
+  size_t const position = read & fifo->mask;                                   \
+  size_t const to_edge  = fifo->mask + 1 - position;                           \
+  size_t const used     = FIFO_TYPED__LOAD(fifo, write, acquire) - read;       \
+                                                                               \
+  if (count > used) {                                                          \
+    count = used;                                                              \
+  }                                                                            \
+                                                                               \
+  if (count <= to_edge) {                                                      \
+    memcpy(dest, &fifo->buffer[position], count * sizeof(type));              \
+  } else {                                                                     \
+    memcpy(dest, &fifo->buffer[position], to_edge * sizeof(type));            \
+    memcpy(dest + to_edge, fifo->buffer, (count - to_edge) * sizeof(type));    \
+  }                                                                            \
+                                                                               \
+  FIFO_TYPED__STORE(fifo, read, read + count, release);                        \
+                                                                               \
+  return count;                                                                \
+}                                                                              \
+                                                                               \
+/* Remove all elements. In SPSC mode this must be called by the consumer. */   \
+static inline void                                                             \
+name ## __flush(name ## _t *fifo)                                              \
+{                                                                              \
+  FIFO_TYPED__STORE(fifo, read, FIFO_TYPED__LOAD(fifo, write, acquire),        \
+                    release);                                                  \
+}
+
+#endif /* FIFO_TYPED_H */
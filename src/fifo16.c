@@ -0,0 +1,14 @@
+#include <fifo.h>
+
+/* fifo16_t
+ *
+ * Fifo with 16 bit indices. See fifo_impl.h for the implementation.
+ */
+
+#define FIFO_T__NAME                              fifo16
+#define FIFO_T__INDEX                             uint16_t
+#define FIFO_T__CURSOR                            uint32_t
+#define FIFO_T__MIRROR                            1
+#define FIFO_T__SIZE_MAX                          FIFO16__SIZE_MAX
+
+#include "fifo_impl.h"
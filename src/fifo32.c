@@ -0,0 +1,14 @@
+#include <fifo.h>
+
+/* fifo32_t
+ *
+ * Fifo with 32 bit indices. See fifo_impl.h for the implementation.
+ */
+
+#define FIFO_T__NAME                              fifo32
+#define FIFO_T__INDEX                             uint32_t
+#define FIFO_T__CURSOR                            uint64_t
+#define FIFO_T__MIRROR                            1
+#define FIFO_T__SIZE_MAX                          FIFO32__SIZE_MAX
+
+#include "fifo_impl.h"
@@ -0,0 +1,275 @@
+#include <fifo_deque.h>
+#include <stdlib.h>
+
+#include "fifo_private.h"
+
+/* Notes:
+ * The elements are the slots from top up to, not including, bottom. The owner
+ * pops by first decrementing bottom and then checking top, a thief steals by
+ * reading top and bottom and then claiming the slot at top with compare and
+ * swap. The sequentially consistent fences between the store and the load on
+ * both sides make sure that when one element is left either the owner sees the
+ * thief's claim or the thief sees the lowered bottom. If both go for the last
+ * element the owner competes with compare and swap on top as well.
+ *
+ * The cursors are free running, differences are taken as ptrdiff_t so that
+ * a bottom one below top, during a pop of an empty deque, reads as -1.
+ */
+
+/* Private Functions -------------------------------------------------------- */
+
+static fifo_deque__ring_t *
+  ring_new(size_t mask);
+
+static fifo_deque__ring_t *
+  grow(fifo_deque_t *deque, fifo_deque__ring_t *ring, size_t top,
+       size_t bottom);
+
+
+/* Function Definitions ----------------------------------------------------- */
+
+/* Initialize a new, empty deque with room for size tasks.
+ *
+ * Sizes that are not a power of 2 are rounded down. Returns
+ * FIFO__INVALID_SIZE if size is below FIFO_DEQUE__SIZE_MIN, or
+ * FIFO__SYSTEM_ERROR if the ring could not be allocated.
+ */
+fifo__result_t
+fifo_deque__ctor(fifo_deque_t *deque, size_t size)
+{
+  fifo_deque__ring_t *ring;
+
+  if (size < FIFO_DEQUE__SIZE_MIN) {
+    return FIFO__INVALID_SIZE;
+  }
+
+  ring = ring_new(fifo__size_to_mask(size));
+
+  if (ring == NULL) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  atomic_init(&deque->top,    0);
+  atomic_init(&deque->bottom, 0);
+  atomic_init(&deque->ring,   ring);
+
+  return FIFO__OK;
+}
+
+
+/* Destroy a deque, freeing the current ring and those it replaced. No thread
+ * may use the deque any more.
+ */
+void
+fifo_deque__dtor(fifo_deque_t *deque)
+{
+  fifo_deque__ring_t *ring =
+    atomic_load_explicit(&deque->ring, memory_order_relaxed);
+
+  while (ring != NULL) {
+    fifo_deque__ring_t * const retired = ring->retired;
+
+    free(ring);
+    ring = retired;
+  }
+
+  atomic_store_explicit(&deque->ring, NULL, memory_order_relaxed);
+}
+
+
+/* Size
+ *
+ * Returns the number of tasks the current ring can hold.
+ */
+size_t
+fifo_deque__size(fifo_deque_t const *deque)
+{
+  return atomic_load_explicit(&deque->ring, memory_order_acquire)->mask + 1;
+}
+
+
+/* Used
+ *
+ * Returns the number of tasks in the deque. Since other threads may be active
+ * the result is only a snapshot.
+ */
+size_t
+fifo_deque__used(fifo_deque_t const *deque)
+{
+  size_t const top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+  size_t const bottom =
+    atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+  ptrdiff_t const used = (ptrdiff_t) (bottom - top);
+
+  return used < 0 ? 0 : (size_t) used;
+}
+
+
+/* Push
+ *
+ * Add a task at the bottom. Owner only. The ring is doubled if it is full,
+ * which returns FIFO__SYSTEM_ERROR if the memory ran out.
+ */
+fifo__result_t
+fifo_deque__push(fifo_deque_t *deque, void *task)
+{
+  size_t const bottom =
+    atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+  size_t const top = atomic_load_explicit(&deque->top, memory_order_acquire);
+  fifo_deque__ring_t *ring =
+    atomic_load_explicit(&deque->ring, memory_order_relaxed);
+
+  if (bottom - top > ring->mask) {
+    ring = grow(deque, ring, top, bottom);
+
+    if (ring == NULL) {
+      return FIFO__SYSTEM_ERROR;
+    }
+  }
+
+  atomic_store_explicit(&ring->slots[bottom & ring->mask], task,
+                        memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+
+  return FIFO__OK;
+}
+
+
+/* Pop
+ *
+ * Take the task at the bottom, the one pushed last. Owner only. Returns
+ * non-zero if there was one.
+ */
+bool_t
+fifo_deque__pop(fifo_deque_t *deque, void **task)
+{
+  size_t const bottom =
+    atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+  fifo_deque__ring_t * const ring =
+    atomic_load_explicit(&deque->ring, memory_order_relaxed);
+  void  *popped;
+  size_t top;
+  bool_t taken = 1;
+
+  atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+  if ((ptrdiff_t) (bottom - top) < 0) {
+    /* Empty */
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+
+    return 0;
+  }
+
+  popped = atomic_load_explicit(&ring->slots[bottom & ring->mask],
+                                memory_order_relaxed);
+
+  if (bottom == top) {
+    /* The last task, race the thieves for it */
+    taken = atomic_compare_exchange_strong_explicit(&deque->top, &top,
+                                                    top + 1,
+                                                    memory_order_seq_cst,
+                                                    memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+  }
+
+  if (taken) {
+    *task = popped;
+  }
+
+  return taken;
+}
+
+
+/* Steal
+ *
+ * Take the task at the top, the oldest one. Any thread. Returns non-zero if a
+ * task was taken, and zero if the deque was empty or another thread took the
+ * task first.
+ */
+bool_t
+fifo_deque__steal(fifo_deque_t *deque, void **task)
+{
+  size_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+  size_t bottom;
+
+  atomic_thread_fence(memory_order_seq_cst);
+  bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+  if ((ptrdiff_t) (bottom - top) > 0) {
+    fifo_deque__ring_t * const ring =
+      atomic_load_explicit(&deque->ring, memory_order_acquire);
+    void * const stolen =
+      atomic_load_explicit(&ring->slots[top & ring->mask],
+                           memory_order_relaxed);
+
+    if (atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                memory_order_seq_cst,
+                                                memory_order_relaxed)) {
+      *task = stolen;
+
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+
+/* Private Function Definitions --------------------------------------------- */
+
+
+/* Ring New [private]
+ *
+ * Allocate a ring of mask + 1 slots. Returns NULL if the memory ran out.
+ */
+fifo_deque__ring_t *
+ring_new(size_t mask)
+{
+  fifo_deque__ring_t *ring;
+
+  if (mask + 1 > (SIZE_MAX - sizeof(fifo_deque__ring_t)) / sizeof(void *)) {
+    return NULL;
+  }
+
+  ring = malloc(sizeof(fifo_deque__ring_t) + (mask + 1) * sizeof(void *));
+
+  if (ring != NULL) {
+    ring->mask    = mask;
+    ring->retired = NULL;
+  }
+
+  return ring;
+}
+
+
+/* Grow [private]
+ *
+ * Replace the ring by one of twice the size holding the same tasks, at the
+ * same cursors. The old ring is kept for thieves that are still reading from
+ * it. Returns the new ring, or NULL if the memory ran out.
+ */
+fifo_deque__ring_t *
+grow(fifo_deque_t *deque, fifo_deque__ring_t *ring, size_t top, size_t bottom)
+{
+  fifo_deque__ring_t * const bigger = ring_new((ring->mask << 1) | 1);
+  size_t i;
+
+  if (bigger == NULL) {
+    return NULL;
+  }
+
+  for (i = top; i != bottom; i ++) {
+    atomic_store_explicit(&bigger->slots[i & bigger->mask],
+                          atomic_load_explicit(&ring->slots[i & ring->mask],
+                                               memory_order_relaxed),
+                          memory_order_relaxed);
+  }
+
+  bigger->retired = ring;
+  atomic_store_explicit(&deque->ring, bigger, memory_order_release);
+
+  return bigger;
+}
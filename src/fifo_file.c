@@ -0,0 +1,571 @@
+#ifdef __unix__
+
+#include <fifo_file.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fifo_private.h"
+
+/* Notes:
+ * A commit first flushes the data written since the last commit, and only
+ * then stores and flushes the commit record. Whatever the kernel writes back
+ * on its own in between, a record that made it to the file never refers to
+ * data that did not. The records are only stored by commits, never by writes
+ * and reads, so the kernel cannot write back a cursor ahead of its data.
+ *
+ * A new file is set up by writing its header with magic number 0, flushing
+ * it, and only then growing the file to its full size and storing the magic
+ * number. A file with magic number 0 is only set up again if it was left by a
+ * crash during that, i.e. if its header is exactly the one of a new fifo and
+ * the file has the size of the header or of the whole fifo. Any other file is
+ * left alone, so a wrong path cannot destroy data that happens to start with
+ * zeros.
+ */
+
+/* Private Functions -------------------------------------------------------- */
+
+static inline fifo__result_t
+  map(fifo_file_t *fifo, size_t len);
+
+static void
+  fresh_header(fifo_file__header_t *header, size_t size, size_t offset);
+
+static bool_t
+  is_unfinished(fifo_file__header_t const *header, size_t len);
+
+static fifo__result_t
+  create(fifo_file_t *fifo, size_t size);
+
+static fifo__result_t
+  recover(fifo_file_t *fifo);
+
+static inline uint32_t
+  checksum(fifo_file__commit_t const *record) PURE;
+
+static fifo__result_t
+  flush(fifo_file_t const *fifo, uint64_t from, uint64_t to);
+
+static inline fifo__result_t
+  flush_range(fifo_file_t const *fifo, size_t position, size_t len);
+
+static inline void
+  maybe_commit(fifo_file_t *fifo);
+
+
+/* Function Definitions ----------------------------------------------------- */
+
+/* Open
+ *
+ * Open the fifo in the file at path, creating the file if it does not exist.
+ * A new fifo holds size bytes, rounded up to a power of 2, while an existing
+ * one keeps its size and is recovered as of its last commit. A commit happens
+ * by itself once sync bytes have been written or read since the last one.
+ * Returns FIFO__SYSTEM_ERROR, with errno set, if the file could not be opened
+ * or created, EWOULDBLOCK if another handle has it open, or EINVAL if it does
+ * not hold a valid fifo.
+ */
+fifo__result_t
+fifo_file__open(fifo_file_t *fifo, char const *path, size_t size, size_t sync)
+{
+  struct stat    st;
+  fifo__result_t res;
+  int            error;
+
+  if (size < FIFO__SIZE_MIN) {
+    size = FIFO__SIZE_MIN;
+  }
+
+  /* Round up to a power of 2 */
+  if (size & (size - 1)) {
+    if (size > FIFOSZ__SIZE_MAX) {
+      return FIFO__INVALID_SIZE;
+    }
+
+    size = (fifo__size_to_mask(size) + 1) << 1;
+  }
+
+  fifo->header = NULL;
+  fifo->mapped = 0;
+  fifo->sync   = sync;
+  fifo->fd     = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+
+  if (fifo->fd < 0) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  if (flock(fifo->fd, LOCK_EX | LOCK_NB) != 0 || fstat(fifo->fd, &st) != 0) {
+    goto fifo_file__open__close;
+  }
+
+  if (st.st_size == 0) {
+    res = create(fifo, size);
+  } else if ((size_t) st.st_size < sizeof(fifo_file__header_t)) {
+    errno = EINVAL;
+    goto fifo_file__open__close;
+  } else if (map(fifo, (size_t) st.st_size) != FIFO__OK) {
+    goto fifo_file__open__close;
+  } else if (fifo->header->magic == 0) {
+    if (!is_unfinished(fifo->header, (size_t) st.st_size)) {
+      errno = EINVAL;
+      goto fifo_file__open__close;
+    }
+
+    munmap(fifo->header, fifo->mapped);
+    res = create(fifo, size);
+  } else {
+    res = recover(fifo);
+  }
+
+  if (res != FIFO__OK) {
+    goto fifo_file__open__close;
+  }
+
+  return FIFO__OK;
+
+fifo_file__open__close:
+  error = errno;
+
+  if (fifo->header != NULL) {
+    munmap(fifo->header, fifo->mapped);
+  }
+
+  close(fifo->fd);
+  fifo->header = NULL;
+  fifo->fd     = -1;
+  errno        = error;
+
+  return FIFO__SYSTEM_ERROR;
+}
+
+
+/* Close
+ *
+ * Commit and close the fifo. The handle is released even if the commit fails,
+ * in which case FIFO__SYSTEM_ERROR is returned with errno set.
+ */
+fifo__result_t
+fifo_file__close(fifo_file_t *fifo)
+{
+  fifo__result_t const res = fifo_file__sync(fifo);
+  int const            error = errno;
+
+  munmap(fifo->header, fifo->mapped);
+  close(fifo->fd);
+
+  fifo->header = NULL;
+  fifo->buffer = NULL;
+  fifo->mask   = 0;
+  fifo->mapped = 0;
+  fifo->fd     = -1;
+  errno        = error;
+
+  return res;
+}
+
+
+/* Sync
+ *
+ * Commit the current cursors, so that the fifo will be recovered as it is
+ * now. Returns FIFO__SYSTEM_ERROR, with errno set, if msync failed, in which
+ * case the last successful commit still holds.
+ */
+fifo__result_t
+fifo_file__sync(fifo_file_t *fifo)
+{
+  uint64_t const       sequence = fifo->sequence + 1;
+  fifo_file__commit_t *record   = &fifo->header->commit[sequence & 1];
+
+  if (fifo->write == fifo->committed_write &&
+      fifo->read == fifo->committed_read) {
+    return FIFO__OK;
+  }
+
+  if (flush(fifo, fifo->committed_write, fifo->write) != FIFO__OK) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  record->sequence = sequence;
+  record->write    = fifo->write;
+  record->read     = fifo->read;
+  record->checksum = checksum(record);
+
+  if (msync(fifo->header, fifo->header->offset, MS_SYNC) != 0) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  fifo->sequence        = sequence;
+  fifo->committed_write = fifo->write;
+  fifo->committed_read  = fifo->read;
+
+  return FIFO__OK;
+}
+
+
+/* Size
+ *
+ * Returns the number of bytes the fifo can hold.
+ */
+size_t
+fifo_file__size(fifo_file_t const *fifo)
+{
+  return fifo->mask + 1;
+}
+
+
+/* Used
+ *
+ * Returns the number of bytes in the fifo.
+ */
+size_t
+fifo_file__used(fifo_file_t const *fifo)
+{
+  return fifo->write - fifo->read;
+}
+
+
+/* Available
+ *
+ * Returns the number of free bytes, including those only freed by reads since
+ * the last commit, which a write commits before reusing them.
+ */
+size_t
+fifo_file__available(fifo_file_t const *fifo)
+{
+  return fifo_file__size(fifo) - fifo_file__used(fifo);
+}
+
+
+/* Write
+ *
+ * Write up to len bytes. Returns the number of bytes written. A commit that
+ * fails here is retried by the next one, fifo_file__sync reports the error.
+ */
+size_t
+fifo_file__write(fifo_file_t *fifo, void const *src, size_t len)
+{
+  size_t const position  = fifo->write & fifo->mask;
+  size_t const to_edge   = fifo->mask + 1 - position;
+  size_t       available =
+    fifo->mask + 1 - (fifo->write - fifo->committed_read);
+
+  if (len > available && fifo->read != fifo->committed_read) {
+    /* Commit the reads to reuse their space */
+    fifo_file__sync(fifo);
+    available = fifo->mask + 1 - (fifo->write - fifo->committed_read);
+  }
+
+  if (len > available) {
+    len = available;
+  }
+
+  if (len <= to_edge) {
+    memcpy(&fifo->buffer[position], src, len);
+  } else {
+    memcpy(&fifo->buffer[position], src, to_edge);
+    memcpy(fifo->buffer, (uint8_t const *) src + to_edge, len - to_edge);
+  }
+
+  fifo->write += len;
+  maybe_commit(fifo);
+
+  return len;
+}
+
+
+/* Read
+ *
+ * Read up to len bytes. Returns the number of bytes read.
+ */
+size_t
+fifo_file__read(fifo_file_t *fifo, void *dest, size_t len)
+{
+  size_t const position = fifo->read & fifo->mask;
+  size_t const to_edge  = fifo->mask + 1 - position;
+  size_t const used     = fifo->write - fifo->read;
+
+  if (len > used) {
+    len = used;
+  }
+
+  if (len <= to_edge) {
+    memcpy(dest, &fifo->buffer[position], len);
+  } else {
+    memcpy(dest, &fifo->buffer[position], to_edge);
+    memcpy((uint8_t *) dest + to_edge, fifo->buffer, len - to_edge);
+  }
+
+  fifo->read += len;
+  maybe_commit(fifo);
+
+  return len;
+}
+
+
+/* Private Function Definitions --------------------------------------------- */
+
+
+/* Map [private]
+ *
+ * Map the first len bytes of the file into the handle. Returns
+ * FIFO__SYSTEM_ERROR, with errno set, on failure.
+ */
+fifo__result_t
+map(fifo_file_t *fifo, size_t len)
+{
+  void *area = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fifo->fd,
+                    0);
+
+  if (area == MAP_FAILED) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  fifo->header = area;
+  fifo->mapped = len;
+
+  return FIFO__OK;
+}
+
+
+/* Fresh Header [private]
+ *
+ * Fill in the header of a new fifo, still without its magic number. Both
+ * commit records are at sequence 0 with empty cursors, only the first is made
+ * valid.
+ */
+void
+fresh_header(fifo_file__header_t *header, size_t size, size_t offset)
+{
+  memset(header, 0, sizeof(*header));
+
+  header->size               = size;
+  header->offset             = offset;
+  header->commit[0].checksum = checksum(&header->commit[0]);
+}
+
+
+/* Is Unfinished [private]
+ *
+ * Returns non-zero if a file of len bytes with the given header was left by
+ * a crash during create.
+ */
+bool_t
+is_unfinished(fifo_file__header_t const *header, size_t len)
+{
+  size_t const        page = (size_t) sysconf(_SC_PAGESIZE);
+  fifo_file__header_t fresh;
+
+  if (header->size < FIFO__SIZE_MIN ||
+      (header->size & (header->size - 1)) != 0 ||
+      header->offset < sizeof(fifo_file__header_t) ||
+      header->offset % page != 0 ||
+      header->size > SIZE_MAX - header->offset) {
+    return 0;
+  }
+
+  if (len != sizeof(fifo_file__header_t) &&
+      len != header->offset + header->size) {
+    return 0;
+  }
+
+  fresh_header(&fresh, header->size, header->offset);
+
+  return memcmp(header, &fresh, sizeof(fresh)) == 0;
+}
+
+
+/* Create [private]
+ *
+ * Set up an empty fifo of size bytes in the file and map it. Returns
+ * FIFO__SYSTEM_ERROR, with errno set, on failure.
+ */
+fifo__result_t
+create(fifo_file_t *fifo, size_t size)
+{
+  size_t const        offset = (size_t) sysconf(_SC_PAGESIZE);
+  fifo_file__header_t fresh;
+  ssize_t             written;
+
+  fifo->header = NULL;
+
+  if (size > SIZE_MAX - offset) {
+    errno = EINVAL;
+
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  fresh_header(&fresh, size, offset);
+
+  if (ftruncate(fifo->fd, 0) != 0) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  written = pwrite(fifo->fd, &fresh, sizeof(fresh), 0);
+
+  if (written >= 0 && (size_t) written != sizeof(fresh)) {
+    errno = EIO;
+  }
+
+  if ((size_t) written != sizeof(fresh) || fdatasync(fifo->fd) != 0 ||
+      ftruncate(fifo->fd, (off_t) (offset + size)) != 0 ||
+      map(fifo, offset + size) != FIFO__OK) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  fifo->buffer          = (uint8_t *) fifo->header + offset;
+  fifo->mask            = size - 1;
+  fifo->write           = 0;
+  fifo->read            = 0;
+  fifo->committed_write = 0;
+  fifo->committed_read  = 0;
+  fifo->sequence        = 0;
+
+  fifo->header->magic = FIFO_FILE__MAGIC;
+
+  if (msync(fifo->header, offset, MS_SYNC) != 0) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  return FIFO__OK;
+}
+
+
+/* Recover [private]
+ *
+ * Check the header of the mapped file and restore the cursors of its latest
+ * intact commit record. Returns FIFO__SYSTEM_ERROR, with errno EINVAL, if the
+ * file does not hold a valid fifo.
+ */
+fifo__result_t
+recover(fifo_file_t *fifo)
+{
+  fifo_file__header_t const * const header = fifo->header;
+  fifo_file__commit_t const *latest = NULL;
+  size_t const page = (size_t) sysconf(_SC_PAGESIZE);
+  size_t i;
+
+  /* Do not trust the header further than the mapping reaches */
+  if (header->magic != FIFO_FILE__MAGIC ||
+      header->size < FIFO__SIZE_MIN ||
+      (header->size & (header->size - 1)) != 0 ||
+      header->offset < sizeof(fifo_file__header_t) ||
+      header->offset % page != 0 ||
+      header->offset > fifo->mapped ||
+      header->size > fifo->mapped - header->offset) {
+    errno = EINVAL;
+
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  for (i = 0; i < 2; i ++) {
+    fifo_file__commit_t const * const record = &header->commit[i];
+
+    if (record->checksum == checksum(record) &&
+        record->write - record->read <= header->size &&
+        (latest == NULL || record->sequence > latest->sequence)) {
+      latest = record;
+    }
+  }
+
+  if (latest == NULL) {
+    errno = EINVAL;
+
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  fifo->buffer          = (uint8_t *) header + header->offset;
+  fifo->mask            = header->size - 1;
+  fifo->write           = latest->write;
+  fifo->read            = latest->read;
+  fifo->committed_write = latest->write;
+  fifo->committed_read  = latest->read;
+  fifo->sequence        = latest->sequence;
+
+  return FIFO__OK;
+}
+
+
+/* Checksum [private]
+ *
+ * Returns the CRC32C of the fields of a commit record before its checksum.
+ */
+uint32_t
+checksum(fifo_file__commit_t const *record)
+{
+  return fifo__crc32c(0, record, offsetof(fifo_file__commit_t, checksum));
+}
+
+
+/* Flush [private]
+ *
+ * Flush the data between the cursors from and to to the file. Returns
+ * FIFO__SYSTEM_ERROR, with errno set, on failure.
+ */
+fifo__result_t
+flush(fifo_file_t const *fifo, uint64_t from, uint64_t to)
+{
+  size_t const start = from & fifo->mask;
+  size_t const end   = to & fifo->mask;
+
+  if (to == from) {
+    return FIFO__OK;
+  }
+
+  if (to - from > fifo->mask) {
+    return flush_range(fifo, 0, fifo->mask + 1);
+  }
+
+  if (start < end) {
+    return flush_range(fifo, start, end - start);
+  }
+
+  if (flush_range(fifo, start, fifo->mask + 1 - start) != FIFO__OK) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  return flush_range(fifo, 0, end);
+}
+
+
+/* Flush Range [private]
+ *
+ * Flush len bytes of the buffer from position on, widened to whole pages.
+ */
+fifo__result_t
+flush_range(fifo_file_t const *fifo, size_t position, size_t len)
+{
+  size_t const page  = (size_t) sysconf(_SC_PAGESIZE);
+  size_t const begin = position & ~(page - 1);
+
+  if (len == 0) {
+    return FIFO__OK;
+  }
+
+  if (msync(fifo->buffer + begin, position + len - begin, MS_SYNC) != 0) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  return FIFO__OK;
+}
+
+
+/* Maybe Commit [private]
+ *
+ * Commit once sync bytes have been written or read since the last commit.
+ */
+void
+maybe_commit(fifo_file_t *fifo)
+{
+  uint64_t const pending = (fifo->write - fifo->committed_write) +
+                           (fifo->read - fifo->committed_read);
+
+  if (pending > 0 && pending >= fifo->sync) {
+    fifo_file__sync(fifo);
+  }
+}
+
+#endif /* __unix__ */
@@ -0,0 +1,76 @@
+#include <fifo.h>
+
+#ifdef FIFO__WAIT
+
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "fifo_private.h"
+
+/* Futex Barrier
+ *
+ * A waiting thread registers itself and then checks the fifo once more, while
+ * a committing thread stores its cursor and then checks for waiters. Both
+ * sides need a full memory barrier between the two steps, or each could miss
+ * the store of the other and the waiter would sleep through the commit.
+ *
+ * Commits are frequent and waits are rare, so the cost is moved to the waiter:
+ * it issues membarrier, which runs a full barrier on every thread of the
+ * process, and commits only need to keep the compiler from reordering. Where
+ * membarrier is not available commits fall back to a fence of their own.
+ */
+
+/* 1 when membarrier is registered, -1 when it is not available, 0 before the
+   first constructor ran. Commits fence themselves unless it is 1. */
+_Atomic(int) fifo__futex_membarrier = 0;
+
+
+/* Function Definitions ----------------------------------------------------- */
+
+/* Futex Setup
+ *
+ * Register the process for membarrier. Called by the fifo constructors, so it
+ * happens before the fifo is handed to another thread. Only the first call of
+ * the process makes a system call.
+ */
+void
+fifo__futex_setup(void)
+{
+  if (atomic_load_explicit(&fifo__futex_membarrier,
+                           memory_order_relaxed) != 0) {
+    return;
+  }
+
+  if (syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED,
+              0, 0) == 0) {
+    atomic_store_explicit(&fifo__futex_membarrier, 1, memory_order_relaxed);
+  } else {
+    atomic_store_explicit(&fifo__futex_membarrier, -1, memory_order_relaxed);
+  }
+}
+
+
+/* Futex Barrier
+ *
+ * Full memory barrier on the waiting side, which also orders the commits of
+ * all other threads, see above. A child process is not registered after fork,
+ * so a failed membarrier registers once more and retries.
+ */
+void
+fifo__futex_barrier(void)
+{
+  if (atomic_load_explicit(&fifo__futex_membarrier,
+                           memory_order_relaxed) != 1) {
+    atomic_thread_fence(memory_order_seq_cst);
+
+    return;
+  }
+
+  if (syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0) != 0) {
+    syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0);
+    syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+  }
+}
+
+#endif /* FIFO__WAIT */
@@ -0,0 +1,1984 @@
+/* Fifo Implementation
+ *
+ * Implements the functions declared by fifo_template.h for one index width.
+ * Each fifo source file includes this file once, after defining the
+ * following parameters:
+ *
+ *   FIFO_T__NAME      Name prefix, see fifo_template.h.
+ *   FIFO_T__INDEX     Unsigned integer type used for the mask and the cursors.
+ *   FIFO_T__CURSOR    Cursor type used in SPSC mode, see fifo_template.h.
+ *   FIFO_T__MIRROR    Optional, enables mirrored buffers.
+ *   FIFO_T__SIZE_MAX  The largest buffer size that can be indexed.
+ */
+
+#ifndef FIFO_T__NAME
+#error "FIFO_T__NAME must be defined before including fifo_impl.h"
+#endif
+
+#include "fifo_private.h"
+
+/* Notes:
+ * The write index points to the next position that can be written to. The read
+ * index points to the first position that can be read from.
+ *
+ * When the buffer is full the read and write indecies will be equal, and the
+ * lowest bit of the mask will be cleared.
+ *
+ * In SPSC mode the cursors instead count every byte ever written and read, and
+ * are masked when indexing the buffer. Their difference is the number of bytes
+ * used, so the full state needs no flag and each cursor is only written by the
+ * side that owns it. The producer publishes written data by storing the write
+ * cursor with release ordering, and the consumer hands the space back by doing
+ * the same with the read cursor. Each side loads the cursor of the other with
+ * acquire ordering before touching the buffer.
+ *
+ * With FIFO__CACHE_ALIGNED each side also keeps the last value it loaded of
+ * the other cursor, read_cache for the producer and write_cache for the
+ * consumer. The copy may lag behind, but only ever towards less space or data
+ * than there really is, so it is enough to load the real cursor when the copy
+ * does not cover the request. While the fifo is neither full nor empty each
+ * side then only touches its own cache line.
+ *
+ * All functions access the cursors through writable/readable and
+ * commit_write/commit_read, which hide the difference between the modes.
+ */
+
+/* Macros ------------------------------------------------------------------- */
+
+#define FIFO__MARK_AS_FULL(mask)                            \
+  mask &= (~0x01)
+
+#define FIFO__IS_ZERO_SIZE(fifo)                            \
+  (fifo->mask == 0)
+
+/* A mirrored buffer is followed by a second mapping of itself, so any run of
+   bytes up to the buffer size is contiguous. */
+#ifdef FIFO_T__MIRROR
+#define FIFO__IS_MIRRORED(fifo)                             \
+  (fifo->mirrored)
+#else
+#define FIFO__IS_MIRRORED(fifo)                   0
+#endif
+
+#ifdef FIFO__SPSC
+#define FIFO__LOAD(fifo, field, order)                      \
+  atomic_load_explicit(&(fifo)->field, memory_order_ ## order)
+#define FIFO__STORE(fifo, field, value, order)              \
+  atomic_store_explicit(&(fifo)->field, value, memory_order_ ## order)
+#else
+#define FIFO__LOAD(fifo, field, order)                      \
+  ((fifo)->field)
+#define FIFO__STORE(fifo, field, value, order)              \
+  ((fifo)->field = (value))
+#endif
+
+/* Update the private copy of the given cursor, if there is one. */
+#ifdef FIFO__CACHE_ALIGNED
+#define FIFO__CACHE(fifo, field, value)                     \
+  ((fifo)->field ## _cache = (value))
+#else
+#define FIFO__CACHE(fifo, field, value)                     \
+  ((void) (value))
+#endif
+
+/* Counters are only written by one side, a relaxed load and store is enough
+   to keep snapshots from other threads free of tearing. */
+#if defined(FIFO__STATS) && defined(FIFO__SPSC)
+#define FIFO__STAT_LOAD(fifo, stat)                         \
+  atomic_load_explicit(&(fifo)->stat, memory_order_relaxed)
+#define FIFO__STAT_STORE(fifo, stat, value)                 \
+  atomic_store_explicit(&(fifo)->stat, value, memory_order_relaxed)
+#else
+#define FIFO__STAT_LOAD(fifo, stat)                         \
+  ((fifo)->stat)
+#define FIFO__STAT_STORE(fifo, stat, value)                 \
+  ((fifo)->stat = (value))
+#endif
+
+#ifdef FIFO__STATS
+#define FIFO__STAT_ADD(fifo, stat, n)                       \
+  FIFO__STAT_STORE(fifo, stat, FIFO__STAT_LOAD(fifo, stat) + (n))
+#else
+#define FIFO__STAT_ADD(fifo, stat, n)                       \
+  ((void) 0)
+#endif
+
+/* Number of times the wait functions check the fifo before going to sleep. */
+#ifndef FIFO__WAIT_SPIN
+#define FIFO__WAIT_SPIN                           100
+#endif
+
+/* Runs shorter than this are copied inline rather than through memcpy, which
+   is slower for just a few bytes. Writes and reads this short also skip the
+   split into runs, as long as they do not wrap around the edge. */
+#define FIFO__SHORT_COPY                          32
+
+/* Writes and reads shorter than this store their bytes one by one. */
+#define FIFO__BYTE_COPY                           4
+
+/* Copy n bytes, if len has that bit set, and move on past them. */
+#define FIFO__COPY_STEP(dest, src, len, n)                  \
+  if ((len) & (n)) {                                        \
+    memcpy((dest), (src), (n));                             \
+    (dest) += (n);                                          \
+    (src)  += (n);                                          \
+  }
+
+typedef FIFO_T__INDEX index_t;
+
+#ifdef FIFO__SPSC
+typedef FIFO_T__CURSOR cursor_t;
+#else
+typedef FIFO_T__INDEX cursor_t;
+#endif
+
+/* Private Functions -------------------------------------------------------- */
+
+static inline size_t
+  used_of(index_t mask, cursor_t read, cursor_t write) PURE;
+
+static inline size_t
+  writable(FIFO_T__TYPE *fifo, index_t *position, size_t wanted);
+
+static inline size_t
+  readable(FIFO_T__TYPE *fifo, index_t *position, size_t wanted);
+
+static inline void
+  commit_write(FIFO_T__TYPE *fifo, size_t len);
+
+static inline void
+  commit_read(FIFO_T__TYPE *fifo, size_t len);
+
+static size_t
+  next_msg(FIFO_T__TYPE *fifo, index_t *position, size_t *len);
+
+static size_t
+  find_byte(FIFO_T__TYPE *fifo, index_t *position, uint8_t byte,
+            size_t *used);
+
+static inline fifo__result_t
+  not_found(FIFO_T__TYPE const *fifo, size_t used) PURE;
+
+#ifdef FIFO__WAIT
+static fifo__result_t
+  wait(FIFO_T__TYPE *fifo,
+       size_t (*ready)(FIFO_T__TYPE *, index_t *, size_t),
+       _Atomic(uint32_t) *futex, _Atomic(uint32_t) *waiters, size_t len,
+       int timeout_ms, fifo__result_t timed_out);
+#endif
+
+#ifdef FIFO__NOTIFY
+static inline void
+  notify_data(FIFO_T__TYPE *fifo);
+
+static inline void
+  notify_space(FIFO_T__TYPE *fifo);
+
+static void
+  arm_data(FIFO_T__TYPE *fifo, cursor_t read);
+
+static void
+  arm_space(FIFO_T__TYPE *fifo);
+#endif
+
+#ifdef __unix__
+static inline void
+  to_iovec(fifo__region_t const regions[2], struct iovec iov[2]);
+#endif
+
+#ifdef FIFO__STATS
+static inline void
+  stats_high_water(FIFO_T__TYPE *fifo);
+#endif
+
+static inline size_t
+  split(FIFO_T__TYPE const *fifo, index_t position, size_t len,
+        fifo__region_t regions[2]);
+
+static inline void
+  copy_in(FIFO_T__TYPE *fifo, index_t position, uint8_t const *src,
+          size_t len);
+
+static inline void
+  copy_out(FIFO_T__TYPE const *fifo, index_t position, uint8_t *dest,
+           size_t len);
+
+static void
+  place(FIFO_T__TYPE *fifo, index_t mask, index_t first, size_t used);
+
+static void
+  grow_buffer(FIFO_T__TYPE *fifo, index_t first, size_t used);
+
+static index_t
+  shrink_buffer(FIFO_T__TYPE *fifo, index_t first, size_t used,
+                index_t mask);
+
+static index_t
+  size_to_mask(size_t size) PURE;
+
+static size_t
+  write_runs(FIFO_T__TYPE *fifo, index_t position, uint8_t const *src,
+             size_t len) NOINLINE;
+
+static size_t
+  read_runs(FIFO_T__TYPE *fifo, index_t position, uint8_t *dest,
+            size_t len) NOINLINE;
+
+static inline void
+  copy(uint8_t *dest, uint8_t const *src, size_t len);
+
+static inline void
+  copy_short(uint8_t *dest, uint8_t const *src, size_t len);
+
+
+/* Global Variables --------------------------------------------------------- */
+
+
+
+
+/* Function Definitions ----------------------------------------------------- */
+
+/* Initialize a new fifo object.
+ *
+ * Calling fifo__ctor(fifo, NULL, 0) will initialize a zero size fifo that will
+ * always read as both empty and full. If instead a buffer handle was provided
+ * the fifo can be resized using fifo__resize.
+ */
+void FIFO_T__FN(ctor)(FIFO_T__TYPE *fifo, void *buffer, size_t size)
+{
+  assert(size <= FIFO_T__SIZE_MAX);
+  assert(size >= FIFO__SIZE_MIN || size == 0);
+
+  WRITE_CONST(fifo->buffer, uint8_t*, buffer);
+  /* Support 0 size buffers */
+  if (size == 0) {
+    place(fifo, 0, 0, 0);
+  } else {
+    place(fifo, size_to_mask(size), 0, 0);
+  }
+
+#ifdef FIFO_T__MIRROR
+  fifo->mirrored = 0;
+#endif
+
+#ifdef FIFO__WAIT
+  atomic_init(&fifo->data_futex,    0);
+  atomic_init(&fifo->data_waiters,  0);
+  atomic_init(&fifo->space_futex,   0);
+  atomic_init(&fifo->space_waiters, 0);
+  fifo__futex_setup();
+#endif
+
+#ifdef FIFO__STATS
+  FIFO__STAT_STORE(fifo, producer_stats.bytes_written, 0);
+  FIFO__STAT_STORE(fifo, producer_stats.short_writes,  0);
+  FIFO__STAT_STORE(fifo, producer_stats.high_water,    0);
+  FIFO__STAT_STORE(fifo, producer_stats.resizes,       0);
+  FIFO__STAT_STORE(fifo, consumer_stats.bytes_read,    0);
+  FIFO__STAT_STORE(fifo, consumer_stats.empty_reads,   0);
+#endif
+
+#ifdef FIFO__NOTIFY
+  fifo->data_fd         = -1;
+  fifo->space_fd        = -1;
+  fifo->space_threshold = 0;
+  atomic_init(&fifo->data_armed,  0);
+  atomic_init(&fifo->space_armed, 0);
+#endif
+}
+
+
+#ifdef FIFO_T__MIRROR
+/* Initialize a fifo on a mirrored buffer.
+ *
+ * The size bytes following the buffer must map to the buffer itself, as set up
+ * by fifo_mirror__ctor. Reads and writes then never have to be split at the
+ * edge of the buffer, and the reserve and peek functions always return the
+ * space as a single region. The size must be a power of 2 and cannot be
+ * changed later.
+ */
+void
+FIFO_T__FN(ctor_mirrored)(FIFO_T__TYPE *fifo, void *buffer, size_t size)
+{
+  assert(size >= FIFO__SIZE_MIN);
+  assert((size & (size - 1)) == 0);
+
+  FIFO_T__FN(ctor)(fifo, buffer, size);
+  fifo->mirrored = 1;
+}
+#endif
+
+
+/* Resize
+ *
+ * Change the size of the fifo buffer. Note that the underlying memory area must
+ * be big enough to contain the new size.
+ */
+fifo__result_t
+FIFO_T__FN(resize)(FIFO_T__TYPE *fifo, size_t new_size)
+{
+  index_t const current_mask = fifo->mask | 0x01;
+  index_t new_mask;
+  index_t first;
+  size_t  used;
+
+  if (new_size == FIFO_T__FN(size)(fifo)) {
+    return FIFO__OK;
+  }
+
+  /* The mirror only covers the current size, and not even 0. */
+  if (FIFO__IS_MIRRORED(fifo)) {
+    return FIFO__INVALID_SIZE;
+  }
+
+  /* Handle zero size fifos */
+  if (new_size == 0) {
+    if (FIFO_T__FN(is_empty)(fifo)) {
+      place(fifo, 0, 0, 0);
+      FIFO__STAT_ADD(fifo, producer_stats.resizes, 1);
+
+      return FIFO__OK;
+    } else {
+      return FIFO__FULL;
+    }
+  }
+
+  if (new_size < FIFO__SIZE_MIN || new_size > FIFO_T__SIZE_MAX) {
+    return FIFO__INVALID_SIZE;
+  }
+
+  /* At this point the buffer must be set. */
+  assert(fifo->buffer != NULL);
+
+  new_mask = size_to_mask(new_size);
+  used     = readable(fifo, &first, SIZE_MAX);
+
+  /* Sizes that round down to the current one leave the fifo as it is */
+  if (new_mask == current_mask) {
+    return FIFO__OK;
+  } else if (used == 0) {
+    first = 0;
+  } else if (new_mask < current_mask) {
+    /* Can we even shrink the buffer? */
+    if (used > (size_t) new_mask + 1) {
+      return FIFO__FULL;
+    }
+
+    first = shrink_buffer(fifo, first, used, new_mask);
+  } else {
+    grow_buffer(fifo, first, used);
+  }
+
+  place(fifo, new_mask, first, used);
+  FIFO__STAT_ADD(fifo, producer_stats.resizes, 1);
+
+  return FIFO__OK;
+}
+
+
+/* Flush
+ *
+ * Empty the fifo and reset it to its pristine state. In SPSC mode this instead
+ * discards everything written so far and must be called by the consumer.
+ */
+void
+FIFO_T__FN(flush)(FIFO_T__TYPE *fifo)
+{
+  if (FIFO__IS_ZERO_SIZE(fifo)) {
+    return;
+  }
+
+#ifdef FIFO__SPSC
+  cursor_t const write = FIFO__LOAD(fifo, write, acquire);
+
+  FIFO__STAT_ADD(fifo, consumer_stats.bytes_read,
+                 (cursor_t) (write - FIFO__LOAD(fifo, read, relaxed)));
+  FIFO__CACHE(fifo, write, write);
+  FIFO__STORE(fifo, read, write, release);
+#ifdef FIFO__WAIT
+  fifo__futex_notify(&fifo->space_futex, &fifo->space_waiters);
+#endif
+#ifdef FIFO__NOTIFY
+  notify_space(fifo);
+#endif
+#else
+  FIFO__STAT_ADD(fifo, consumer_stats.bytes_read, FIFO_T__FN(used)(fifo));
+  fifo->read  = 0;
+  fifo->write = 0;
+  fifo->mask |= 0x01;
+#endif
+}
+
+/* Is Empty
+ *
+ * Returns non-zero if the fifo is empty.
+ */
+bool_t
+FIFO_T__FN(is_empty)(FIFO_T__TYPE const *fifo)
+{
+  return FIFO_T__FN(used)(fifo) == 0;
+}
+
+
+/* Size
+ *
+ * Returns the total size of the buffer in bytes.
+ */
+size_t
+FIFO_T__FN(size)(FIFO_T__TYPE const *fifo)
+{
+  if (FIFO__IS_ZERO_SIZE(fifo)) {
+    return 0;
+  }
+
+  return (size_t) (fifo->mask | 0x01) + 1;
+}
+
+
+/* Used
+ *
+ * Returns the number of bytes currently used.
+ */
+size_t
+FIFO_T__FN(used)(FIFO_T__TYPE const *fifo)
+{
+  /* In SPSC mode read must be loaded first, write can only have moved further
+     ahead of it in the meantime. */
+  cursor_t const read = FIFO__LOAD(fifo, read, acquire);
+
+  return used_of(fifo->mask, read, FIFO__LOAD(fifo, write, acquire));
+}
+
+
+/* Available
+ *
+ * Returns the number of free bytes in the buffer.
+ */
+size_t
+FIFO_T__FN(available)(FIFO_T__TYPE const *fifo)
+{
+  return FIFO_T__FN(size)(fifo) - FIFO_T__FN(used)(fifo);
+}
+
+/* Write
+ *
+ * Writes the given src buffer to the fifo.
+ * The write cursor points to the position in the buffer that should be written
+ * to next. The data is copied in at most two runs, one up to the edge of the
+ * buffer and one from the start of it.
+ */
+size_t
+FIFO_T__FN(write)(FIFO_T__TYPE *fifo, void const *src, size_t len)
+{
+  index_t position;
+  size_t  available;
+
+  assert(fifo != NULL);
+  assert(src != NULL);
+  assert(len > 0);
+
+  available = writable(fifo, &position, len);
+
+  /* Small writes that fit skip the split into runs. A single byte is stored
+     directly, a few bytes one by one and a short write that ends before the
+     edge of the buffer in one run. */
+  if (len == 1 && available > 0) {
+    fifo->buffer[position] = *(uint8_t const *) src;
+    commit_write(fifo, 1);
+
+    return 1;
+  }
+  if (len < FIFO__BYTE_COPY && len <= available) {
+    index_t const  mask       = fifo->mask | 0x01;
+    uint8_t const *src_buffer = (uint8_t const *) src;
+    size_t         i;
+
+    fifo->buffer[position] = src_buffer[0];
+    for (i = 1; i < len; i ++) {
+      fifo->buffer[(position + i) & mask] = src_buffer[i];
+    }
+    commit_write(fifo, len);
+
+    return len;
+  }
+  if (len < FIFO__SHORT_COPY && len <= available &&
+      len <= (size_t) (fifo->mask | 0x01) + 1 - position) {
+    copy_short(&fifo->buffer[position], (uint8_t const *) src, len);
+    commit_write(fifo, len);
+
+    return len;
+  }
+
+  if (len > available) {
+    FIFO__STAT_ADD(fifo, producer_stats.short_writes, 1);
+    len = available;
+  }
+
+  if (len == 0) {
+    return 0;
+  }
+
+  return write_runs(fifo, position, (uint8_t const *) src, len);
+}
+
+
+/* Force Write
+ *
+ * Writes the given src buffer to the fifo, discarding the oldest bytes to make
+ * room for it. If len is larger than the fifo only the last bytes of src are
+ * kept. Returns the number of bytes that were discarded, counting both bytes
+ * evicted from the fifo and bytes of src that did not fit.
+ *
+ * Evicting moves the read cursor, so in SPSC mode this must not be called
+ * while the consumer is active.
+ */
+size_t
+FIFO_T__FN(write_force)(FIFO_T__TYPE *fifo, void const *src, size_t len)
+{
+  size_t const   size       = FIFO_T__FN(size)(fifo);
+  uint8_t const *src_buffer = (uint8_t const *) src;
+  size_t         discarded  = 0;
+  size_t         available;
+  index_t        position;
+
+  assert(fifo != NULL);
+  assert(src != NULL);
+
+  if (len > size) {
+    discarded   = len - size;
+    src_buffer += discarded;
+    len         = size;
+  }
+
+  available = writable(fifo, &position, len);
+
+  /* Evict the oldest bytes in one step */
+  if (len > available) {
+    discarded += len - available;
+    commit_read(fifo, len - available);
+    FIFO__CACHE(fifo, read, FIFO__LOAD(fifo, read, relaxed));
+  }
+
+  copy_in(fifo, position, src_buffer, len);
+  commit_write(fifo, len);
+
+  return discarded;
+}
+
+
+/* Read
+ *
+ * Read a number of bytes from the buffer.
+ * Returns the number of bytes that where successfully read. Like write, the
+ * data is copied in at most two runs.
+ */
+size_t
+FIFO_T__FN(read)(FIFO_T__TYPE *fifo, void *dest, size_t len)
+{
+  index_t position;
+  size_t  used;
+
+  assert(fifo != NULL);
+  assert(dest != NULL);
+  assert(len > 0);
+
+  used = readable(fifo, &position, len);
+
+  if (used == 0) {
+    FIFO__STAT_ADD(fifo, consumer_stats.empty_reads, 1);
+    return 0;
+  }
+
+  /* Small reads skip the split into runs, like in write */
+  if (len == 1) {
+    *(uint8_t *) dest = fifo->buffer[position];
+    commit_read(fifo, 1);
+
+    return 1;
+  }
+  if (len < FIFO__BYTE_COPY && len <= used) {
+    index_t const mask        = fifo->mask | 0x01;
+    uint8_t      *dest_buffer = (uint8_t *) dest;
+    size_t        i;
+
+    dest_buffer[0] = fifo->buffer[position];
+    for (i = 1; i < len; i ++) {
+      dest_buffer[i] = fifo->buffer[(position + i) & mask];
+    }
+    commit_read(fifo, len);
+
+    return len;
+  }
+  if (len < FIFO__SHORT_COPY && len <= used &&
+      len <= (size_t) (fifo->mask | 0x01) + 1 - position) {
+    copy_short((uint8_t *) dest, &fifo->buffer[position], len);
+    commit_read(fifo, len);
+
+    return len;
+  }
+
+  if (len > used) {
+    len = used;
+  }
+
+  return read_runs(fifo, position, (uint8_t *) dest, len);
+}
+
+
+/* Write Reserve
+ *
+ * Hand out the free space of the fifo so that data can be written to it in
+ * place. The space is returned as two regions, the second of which starts at
+ * the beginning of the buffer and is empty unless the space wraps around the
+ * edge. Returns the total number of bytes in the regions.
+ *
+ * Nothing is written until fifo__write_commit is called. Reserving again before
+ * that hands out the same space.
+ */
+size_t
+FIFO_T__FN(write_reserve)(FIFO_T__TYPE *fifo, fifo__region_t regions[2])
+{
+  index_t position;
+  size_t  available = writable(fifo, &position, SIZE_MAX);
+
+  return split(fifo, position, available, regions);
+}
+
+
+/* Write Commit
+ *
+ * Add the first len bytes of the space handed out by fifo__write_reserve to
+ * the fifo.
+ */
+void
+FIFO_T__FN(write_commit)(FIFO_T__TYPE *fifo, size_t len)
+{
+  assert(len <= FIFO_T__FN(available)(fifo));
+
+  commit_write(fifo, len);
+}
+
+
+/* Read Peek
+ *
+ * Hand out the used bytes of the fifo without removing them, as two regions in
+ * the same way as fifo__write_reserve. Returns the total number of bytes in the
+ * regions.
+ *
+ * With FIFO__CACHE_ALIGNED the fifo is modified to refresh the consumer's copy
+ * of the write cursor, which is not visible from the outside.
+ */
+size_t
+FIFO_T__FN(read_peek)(FIFO_T__TYPE const *fifo, fifo__region_t regions[2])
+{
+  index_t position;
+  size_t  used = readable((FIFO_T__TYPE *) fifo, &position, SIZE_MAX);
+
+  return split(fifo, position, used, regions);
+}
+
+
+/* Read Consume
+ *
+ * Remove the first len bytes handed out by fifo__read_peek from the fifo.
+ */
+void
+FIFO_T__FN(read_consume)(FIFO_T__TYPE *fifo, size_t len)
+{
+  assert(len <= FIFO_T__FN(used)(fifo));
+
+  commit_read(fifo, len);
+}
+
+
+/* Push Message
+ *
+ * Write len bytes from src to the fifo as one message, preceded by its length
+ * encoded as a varint. The message is written completely or not at all.
+ * Returns FIFO__FULL if there is not enough space for it right now, and
+ * FIFO__INVALID_SIZE if it would never fit.
+ *
+ * Messages and plain bytes should not be mixed in the same fifo, since the
+ * message functions take the first bytes in the fifo to be a length.
+ */
+fifo__result_t
+FIFO_T__FN(push_msg)(FIFO_T__TYPE *fifo, void const *src, size_t len)
+{
+  size_t const size = FIFO_T__FN(size)(fifo);
+  uint8_t header[FIFO__VARINT_MAX];
+  size_t  header_len;
+  index_t position;
+  size_t  i;
+
+  if (len >= size) {
+    return FIFO__INVALID_SIZE;
+  }
+
+  header_len = fifo__varint_encode(len, header);
+
+  if (header_len + len > size) {
+    return FIFO__INVALID_SIZE;
+  }
+
+  if (writable(fifo, &position, header_len + len) < header_len + len) {
+    FIFO__STAT_ADD(fifo, producer_stats.short_writes, 1);
+    return FIFO__FULL;
+  }
+
+  /* The header is only a few bytes */
+  for (i = 0; i < header_len; i ++) {
+    fifo->buffer[(position + i) & (fifo->mask | 0x01)] = header[i];
+  }
+
+  copy_in(fifo, (position + header_len) & (fifo->mask | 0x01),
+          (uint8_t const *) src, len);
+
+  /* Both parts become visible at once */
+  commit_write(fifo, header_len + len);
+
+  return FIFO__OK;
+}
+
+
+/* Pop Message
+ *
+ * Read the next message written by fifo__push_msg into dest, which can hold
+ * size bytes, and set len to its length. Returns FIFO__EMPTY if there is no
+ * message. If the message is larger than size, FIFO__INVALID_SIZE is returned
+ * and the message is left in the fifo, with len still set.
+ */
+fifo__result_t
+FIFO_T__FN(pop_msg)(FIFO_T__TYPE *fifo, void *dest, size_t size, size_t *len)
+{
+  index_t position;
+  size_t  header_len = next_msg(fifo, &position, len);
+
+  if (header_len == 0) {
+    FIFO__STAT_ADD(fifo, consumer_stats.empty_reads, 1);
+    return FIFO__EMPTY;
+  }
+
+  if (*len > size) {
+    return FIFO__INVALID_SIZE;
+  }
+
+  copy_out(fifo, (position + header_len) & (fifo->mask | 0x01),
+           (uint8_t *) dest, *len);
+  commit_read(fifo, header_len + *len);
+
+  return FIFO__OK;
+}
+
+
+/* Next Message Length
+ *
+ * Set len to the length of the next message without removing it. Returns
+ * FIFO__EMPTY if there is no message.
+ */
+fifo__result_t
+FIFO_T__FN(next_msg_len)(FIFO_T__TYPE const *fifo, size_t *len)
+{
+  index_t position;
+
+  if (next_msg((FIFO_T__TYPE *) fifo, &position, len) == 0) {
+    return FIFO__EMPTY;
+  }
+
+  return FIFO__OK;
+}
+
+
+/* Write with Checksum
+ *
+ * Like write, and additionally feeds the bytes written into the CRC32C at crc,
+ * in the same pass that copies them. Start a message with a crc of 0.
+ */
+size_t
+FIFO_T__FN(write_crc)(FIFO_T__TYPE *fifo, void const *src, size_t len,
+                      uint32_t *crc)
+{
+  uint8_t const *src_buffer = src;
+  fifo__region_t regions[2];
+  index_t        position;
+  size_t         available;
+
+  assert(len > 0);
+
+  available = writable(fifo, &position, len);
+
+  if (len > available) {
+    FIFO__STAT_ADD(fifo, producer_stats.short_writes, 1);
+    len = available;
+  }
+
+  if (len == 0) {
+    return 0;
+  }
+
+  split(fifo, position, len, regions);
+  *crc = fifo__crc32c_copy(*crc, regions[0].data, src_buffer, regions[0].len);
+  *crc = fifo__crc32c_copy(*crc, regions[1].data, src_buffer + regions[0].len,
+                           regions[1].len);
+  commit_write(fifo, len);
+
+  return len;
+}
+
+
+/* Read with Checksum
+ *
+ * Like read, and additionally feeds the bytes read into the CRC32C at crc, in
+ * the same pass that copies them.
+ */
+size_t
+FIFO_T__FN(read_crc)(FIFO_T__TYPE *fifo, void *dest, size_t len,
+                     uint32_t *crc)
+{
+  uint8_t       *dest_buffer = dest;
+  fifo__region_t regions[2];
+  index_t        position;
+  size_t         used;
+
+  assert(len > 0);
+
+  used = readable(fifo, &position, len);
+
+  if (used == 0) {
+    FIFO__STAT_ADD(fifo, consumer_stats.empty_reads, 1);
+    return 0;
+  }
+
+  if (len > used) {
+    len = used;
+  }
+
+  split(fifo, position, len, regions);
+  *crc = fifo__crc32c_copy(*crc, dest_buffer, regions[0].data, regions[0].len);
+  *crc = fifo__crc32c_copy(*crc, dest_buffer + regions[0].len, regions[1].data,
+                           regions[1].len);
+  commit_read(fifo, len);
+
+  return len;
+}
+
+
+/* Find
+ *
+ * Set offset to the position of the first occurrence of byte, counted from the
+ * next byte to be read, without removing anything. Returns FIFO__EMPTY if the
+ * byte is not in the fifo, or FIFO__FULL if it is not in the fifo and the
+ * fifo is full, so that it cannot arrive before something is read.
+ */
+fifo__result_t
+FIFO_T__FN(find)(FIFO_T__TYPE const *fifo, uint8_t byte, size_t *offset)
+{
+  index_t position;
+  size_t  used;
+  size_t  len = find_byte((FIFO_T__TYPE *) fifo, &position, byte, &used);
+
+  if (len == 0) {
+    return not_found(fifo, used);
+  }
+
+  *offset = len - 1;
+
+  return FIFO__OK;
+}
+
+
+/* Read Until
+ *
+ * Read the bytes up to and including the first occurrence of delim into dest,
+ * which can hold size bytes, and set len to their number. Returns FIFO__EMPTY,
+ * and reads nothing, if delim is not in the fifo. If the fifo is full without
+ * holding delim the record can never be completed, which is reported as
+ * FIFO__FULL, again reading nothing, so that the caller can drain the fifo
+ * with read or flush. If the bytes do not fit in dest, FIFO__INVALID_SIZE is
+ * returned and they are left in the fifo, with len still set.
+ */
+fifo__result_t
+FIFO_T__FN(read_until)(FIFO_T__TYPE *fifo, void *dest, size_t size,
+                       uint8_t delim, size_t *len)
+{
+  index_t position;
+  size_t  used;
+
+  *len = find_byte(fifo, &position, delim, &used);
+
+  if (*len == 0) {
+    FIFO__STAT_ADD(fifo, consumer_stats.empty_reads, 1);
+    return not_found(fifo, used);
+  }
+
+  if (*len > size) {
+    return FIFO__INVALID_SIZE;
+  }
+
+  copy_out(fifo, position, (uint8_t *) dest, *len);
+  commit_read(fifo, *len);
+
+  return FIFO__OK;
+}
+
+
+#ifdef FIFO__STATS
+/* Statistics
+ *
+ * Take a snapshot of the counters. The counters of each side are only written
+ * by that side, so a snapshot may be taken by any thread, but the producer and
+ * consumer counters may be from slightly different moments.
+ */
+void
+FIFO_T__FN(stats)(FIFO_T__TYPE const *fifo, fifo__stats_t *stats)
+{
+  stats->bytes_written = FIFO__STAT_LOAD(fifo, producer_stats.bytes_written);
+  stats->bytes_read    = FIFO__STAT_LOAD(fifo, consumer_stats.bytes_read);
+  stats->short_writes  = FIFO__STAT_LOAD(fifo, producer_stats.short_writes);
+  stats->empty_reads   = FIFO__STAT_LOAD(fifo, consumer_stats.empty_reads);
+  stats->high_water    = FIFO__STAT_LOAD(fifo, producer_stats.high_water);
+  stats->resizes       = FIFO__STAT_LOAD(fifo, producer_stats.resizes);
+}
+#endif
+
+
+#ifdef __unix__
+/* Write Vector
+ *
+ * Writes the buffers of an iovec array to the fifo, in order, as if they were
+ * one buffer passed to fifo__write. Returns the number of bytes written.
+ */
+size_t
+FIFO_T__FN(writev)(FIFO_T__TYPE *fifo, struct iovec const *iov, int iovcnt)
+{
+  index_t const mask = fifo->mask | 0x01;
+  index_t position;
+  size_t  available;
+  size_t  written = 0;
+  int     i;
+
+  assert(iovcnt >= 0);
+
+  available = writable(fifo, &position, SIZE_MAX);
+
+  for (i = 0; i < iovcnt; i ++) {
+    size_t const len = iov[i].iov_len;
+
+    /* Also counts a write into a full fifo, which copies nothing */
+    if (len > available - written) {
+      FIFO__STAT_ADD(fifo, producer_stats.short_writes, 1);
+      copy_in(fifo, (position + written) & mask,
+              (uint8_t const *) iov[i].iov_base, available - written);
+      written = available;
+      break;
+    }
+
+    copy_in(fifo, (position + written) & mask,
+            (uint8_t const *) iov[i].iov_base, len);
+    written += len;
+  }
+
+  commit_write(fifo, written);
+
+  return written;
+}
+
+
+/* Read Vector
+ *
+ * Reads from the fifo into the buffers of an iovec array, filling each one
+ * before moving on to the next. Returns the number of bytes read.
+ */
+size_t
+FIFO_T__FN(readv)(FIFO_T__TYPE *fifo, struct iovec const *iov, int iovcnt)
+{
+  index_t const mask = fifo->mask | 0x01;
+  index_t position;
+  size_t  used;
+  size_t  read = 0;
+  int     i;
+
+  assert(iovcnt >= 0);
+
+  used = readable(fifo, &position, SIZE_MAX);
+
+  if (used == 0) {
+    FIFO__STAT_ADD(fifo, consumer_stats.empty_reads, 1);
+  }
+
+  for (i = 0; i < iovcnt && read < used; i ++) {
+    size_t len = iov[i].iov_len;
+
+    if (len > used - read) {
+      len = used - read;
+    }
+
+    copy_out(fifo, (position + read) & mask, (uint8_t *) iov[i].iov_base,
+             len);
+    read += len;
+  }
+
+  commit_read(fifo, read);
+
+  return read;
+}
+
+
+/* Read From Fd
+ *
+ * Fill the free space of the fifo with a single readv call on fd, without an
+ * intermediate buffer. Sets len to the number of bytes read, which is 0 at the
+ * end of the file. Returns FIFO__FULL if there is no space, and
+ * FIFO__SYSTEM_ERROR with errno set if readv fails, e.g. with EAGAIN on a non
+ * blocking fd.
+ */
+fifo__result_t
+FIFO_T__FN(read_from_fd)(FIFO_T__TYPE *fifo, int fd, size_t *len)
+{
+  fifo__region_t regions[2];
+  struct iovec   iov[2];
+  index_t        position;
+  size_t         available;
+  ssize_t        ret;
+
+  *len      = 0;
+  available = writable(fifo, &position, SIZE_MAX);
+
+  if (available == 0) {
+    FIFO__STAT_ADD(fifo, producer_stats.short_writes, 1);
+    return FIFO__FULL;
+  }
+
+  split(fifo, position, available, regions);
+  to_iovec(regions, iov);
+
+  ret = readv(fd, iov, regions[1].len > 0 ? 2 : 1);
+
+  if (ret < 0) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  commit_write(fifo, ret);
+  *len = ret;
+
+  return FIFO__OK;
+}
+
+
+/* Write To Fd
+ *
+ * Send the data in the fifo to fd with a single writev call. Sets len to the
+ * number of bytes written, which are removed from the fifo. Returns
+ * FIFO__EMPTY if there is no data, and FIFO__SYSTEM_ERROR with errno set if
+ * writev fails.
+ */
+fifo__result_t
+FIFO_T__FN(write_to_fd)(FIFO_T__TYPE *fifo, int fd, size_t *len)
+{
+  fifo__region_t regions[2];
+  struct iovec   iov[2];
+  index_t        position;
+  size_t         used;
+  ssize_t        ret;
+
+  *len = 0;
+  used = readable(fifo, &position, SIZE_MAX);
+
+  if (used == 0) {
+    FIFO__STAT_ADD(fifo, consumer_stats.empty_reads, 1);
+    return FIFO__EMPTY;
+  }
+
+  split(fifo, position, used, regions);
+  to_iovec(regions, iov);
+
+  ret = writev(fd, iov, regions[1].len > 0 ? 2 : 1);
+
+  if (ret < 0) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  commit_read(fifo, ret);
+  *len = ret;
+
+  return FIFO__OK;
+}
+#endif
+
+
+#ifdef FIFO__WAIT
+/* Read Wait
+ *
+ * Block until at least len bytes can be read, or until timeout_ms milliseconds
+ * have passed. A negative timeout waits forever and 0 only checks. Returns
+ * FIFO__OK, or FIFO__EMPTY if the timeout expired. Must only be called by the
+ * consumer.
+ */
+fifo__result_t
+FIFO_T__FN(read_wait)(FIFO_T__TYPE *fifo, size_t len, int timeout_ms)
+{
+  assert(len > 0);
+  assert(len <= FIFO_T__FN(size)(fifo));
+
+  return wait(fifo, readable, &fifo->data_futex, &fifo->data_waiters, len,
+              timeout_ms, FIFO__EMPTY);
+}
+
+
+/* Write Wait
+ *
+ * Block until at least len bytes can be written, or until timeout_ms
+ * milliseconds have passed, in the same way as fifo__read_wait. Returns
+ * FIFO__OK, or FIFO__FULL if the timeout expired. Must only be called by the
+ * producer.
+ */
+fifo__result_t
+FIFO_T__FN(write_wait)(FIFO_T__TYPE *fifo, size_t len, int timeout_ms)
+{
+  assert(len > 0);
+  assert(len <= FIFO_T__FN(size)(fifo));
+
+  return wait(fifo, writable, &fifo->space_futex, &fifo->space_waiters, len,
+              timeout_ms, FIFO__FULL);
+}
+#endif
+
+
+#ifdef FIFO__NOTIFY
+/* Notify Constructor
+ *
+ * Create the eventfds of the fifo, for use with epoll and the like. The data
+ * fd becomes readable when data arrives in the empty fifo, and the space fd
+ * when at least space_threshold bytes are free again after the producer found
+ * less than that, or less than it asked for. The threshold must be at least 1,
+ * and if it is below the size of the writes the producer may be woken before
+ * its next write fits.
+ *
+ * Each fd is signalled at most once until the side waiting for it runs out of
+ * data or space again, so a burst of writes costs a single system call. After
+ * waking up, the consumer should first read the data fd to clear it and then
+ * read from the fifo until it is empty, since only an empty read rearms the
+ * notification. The producer does the same with the space fd, writing until a
+ * write comes up short.
+ *
+ * Returns FIFO__SYSTEM_ERROR, with errno set, if the eventfds could not be
+ * created. Must not run concurrently with anything else.
+ */
+fifo__result_t
+FIFO_T__FN(notify_ctor)(FIFO_T__TYPE *fifo, size_t space_threshold)
+{
+  int error;
+
+  assert(space_threshold > 0);
+  assert(space_threshold <= FIFO_T__FN(size)(fifo));
+
+  fifo->data_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+  if (fifo->data_fd < 0) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  fifo->space_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+  if (fifo->space_fd < 0) {
+    error = errno;
+    close(fifo->data_fd);
+    fifo->data_fd = -1;
+    errno = error;
+
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  fifo->space_threshold = space_threshold;
+
+  /* Signal data that is already there */
+  atomic_store_explicit(&fifo->data_armed,  1, memory_order_relaxed);
+  atomic_store_explicit(&fifo->space_armed, 0, memory_order_relaxed);
+
+  if (!FIFO_T__FN(is_empty)(fifo)) {
+    notify_data(fifo);
+  }
+
+  return FIFO__OK;
+}
+
+
+/* Notify Destructor
+ *
+ * Close the eventfds of the fifo. Must not run concurrently with anything
+ * else.
+ */
+void
+FIFO_T__FN(notify_dtor)(FIFO_T__TYPE *fifo)
+{
+  atomic_store_explicit(&fifo->data_armed,  0, memory_order_relaxed);
+  atomic_store_explicit(&fifo->space_armed, 0, memory_order_relaxed);
+
+  if (fifo->data_fd >= 0) {
+    close(fifo->data_fd);
+  }
+
+  if (fifo->space_fd >= 0) {
+    close(fifo->space_fd);
+  }
+
+  fifo->data_fd         = -1;
+  fifo->space_fd        = -1;
+  fifo->space_threshold = 0;
+}
+
+
+/* Data Fd
+ *
+ * Returns the eventfd that becomes readable when data arrives, or -1.
+ */
+int
+FIFO_T__FN(data_fd)(FIFO_T__TYPE const *fifo)
+{
+  return fifo->data_fd;
+}
+
+
+/* Space Fd
+ *
+ * Returns the eventfd that becomes readable when space frees up, or -1.
+ */
+int
+FIFO_T__FN(space_fd)(FIFO_T__TYPE const *fifo)
+{
+  return fifo->space_fd;
+}
+#endif
+
+
+/* Private Function Definitions --------------------------------------------- */
+
+
+/* Used Of [private]
+ *
+ * Returns the number of bytes used, given the mask and a pair of cursors.
+ */
+size_t
+used_of(index_t mask, cursor_t read, cursor_t write)
+{
+  if (mask == 0) { // FIFO__IS_ZERO_SIZE
+    return 0;
+  }
+
+#ifdef FIFO__SPSC
+  return (cursor_t) (write - read);
+#else
+  /* If full */
+  if ((mask & 0x01) == 0) {
+    return (size_t) mask + 2;
+  }
+
+  return (index_t) (write - read) & mask;
+#endif
+}
+
+
+/* Writable [private]
+ *
+ * Returns the number of bytes that can be written, and sets position to the
+ * index in the buffer where writing starts. Must only be called by the
+ * producer. The read cursor is only loaded if the cached copy of it leaves
+ * less than wanted bytes of space.
+ */
+size_t
+writable(FIFO_T__TYPE *fifo, index_t *position, size_t wanted)
+{
+  index_t  const mask  = fifo->mask;
+  size_t   const size  = (size_t) (mask | 0x01) + 1;
+  cursor_t const write = FIFO__LOAD(fifo, write, relaxed);
+  cursor_t       read;
+
+  *position = write & (mask | 0x01);
+
+  if (mask == 0) { // FIFO__IS_ZERO_SIZE
+    return 0;
+  }
+
+#ifdef FIFO__CACHE_ALIGNED
+  read = fifo->read_cache;
+
+  if (size - used_of(mask, read, write) >= wanted) {
+    return size - used_of(mask, read, write);
+  }
+#else
+  (void) wanted;
+#endif
+
+  read = FIFO__LOAD(fifo, read, acquire);
+  FIFO__CACHE(fifo, read, read);
+
+#ifdef FIFO__NOTIFY
+  /* The producer comes up short, wanted larger than the fifo only asks for all
+     of the space there is. */
+  if (size - used_of(mask, read, write) < fifo->space_threshold ||
+      (size - used_of(mask, read, write) < wanted && wanted <= size)) {
+    arm_space(fifo);
+  }
+#endif
+
+  return size - used_of(mask, read, write);
+}
+
+
+/* Readable [private]
+ *
+ * Returns the number of bytes that can be read, and sets position to the index
+ * in the buffer where reading starts. Must only be called by the consumer. The
+ * write cursor is only loaded if the cached copy of it holds less than wanted
+ * bytes.
+ */
+size_t
+readable(FIFO_T__TYPE *fifo, index_t *position, size_t wanted)
+{
+  index_t  const mask = fifo->mask;
+  cursor_t const read = FIFO__LOAD(fifo, read, relaxed);
+  cursor_t       write;
+
+  *position = read & (mask | 0x01);
+
+#ifdef FIFO__CACHE_ALIGNED
+  write = fifo->write_cache;
+
+  if (used_of(mask, read, write) >= wanted) {
+    return used_of(mask, read, write);
+  }
+#else
+  (void) wanted;
+#endif
+
+  write = FIFO__LOAD(fifo, write, acquire);
+  FIFO__CACHE(fifo, write, write);
+
+#ifdef FIFO__NOTIFY
+  if (write == read) {
+    arm_data(fifo, read);
+  }
+#endif
+
+  return used_of(mask, read, write);
+}
+
+
+/* Commit Write [private]
+ *
+ * Advance the write cursor past len bytes that have been copied into the
+ * buffer, making them visible to the consumer.
+ */
+void
+commit_write(FIFO_T__TYPE *fifo, size_t len)
+{
+  FIFO__STAT_ADD(fifo, producer_stats.bytes_written, len);
+
+#ifdef FIFO__SPSC
+  FIFO__STORE(fifo, write,
+              FIFO__LOAD(fifo, write, relaxed) + (cursor_t) len, release);
+#ifdef FIFO__STATS
+  stats_high_water(fifo);
+#endif
+#ifdef FIFO__WAIT
+  fifo__futex_notify(&fifo->data_futex, &fifo->data_waiters);
+#endif
+#ifdef FIFO__NOTIFY
+  notify_data(fifo);
+#endif
+#else
+  index_t mask = fifo->mask;
+  index_t cursor;
+
+  if (len == 0) {
+    return;
+  }
+
+  cursor = (fifo->write + len) & mask;
+
+  if (cursor == fifo->read) {
+    FIFO__MARK_AS_FULL(mask);
+    fifo->mask = mask;
+  }
+
+  /* Update write position */
+  fifo->write = cursor;
+
+#ifdef FIFO__STATS
+  stats_high_water(fifo);
+#endif
+#endif
+}
+
+
+/* Commit Read [private]
+ *
+ * Advance the read cursor past len bytes, handing the space back to the
+ * producer.
+ */
+void
+commit_read(FIFO_T__TYPE *fifo, size_t len)
+{
+  FIFO__STAT_ADD(fifo, consumer_stats.bytes_read, len);
+
+#ifdef FIFO__SPSC
+  FIFO__STORE(fifo, read,
+              FIFO__LOAD(fifo, read, relaxed) + (cursor_t) len, release);
+#ifdef FIFO__WAIT
+  fifo__futex_notify(&fifo->space_futex, &fifo->space_waiters);
+#endif
+#ifdef FIFO__NOTIFY
+  notify_space(fifo);
+#endif
+#else
+  index_t const mask = fifo->mask | 0x01;
+
+  if (len == 0) {
+    return;
+  }
+
+  fifo->mask = mask;
+  fifo->read = (fifo->read + len) & mask;
+#endif
+}
+
+
+/* Next Message [private]
+ *
+ * Decode the length of the first message in the fifo. Returns the length of
+ * its header, or 0 if the fifo does not hold a complete message, and sets
+ * position to the start of the header and len to the length of the message.
+ */
+size_t
+next_msg(FIFO_T__TYPE *fifo, index_t *position, size_t *len)
+{
+  index_t const mask  = fifo->mask | 0x01;
+  size_t  const used  = readable(fifo, position, 1);
+  size_t        value = 0;
+  size_t        i;
+
+  for (i = 0; i < used && i < FIFO__VARINT_MAX; i ++) {
+    uint8_t const byte = fifo->buffer[(*position + i) & mask];
+
+    value |= (size_t) (byte & 0x7F) << (i * 7);
+
+    if ((byte & 0x80) == 0) {
+      if (used - (i + 1) < value) {
+        break;
+      }
+
+      *len = value;
+
+      return i + 1;
+    }
+  }
+
+  return 0;
+}
+
+
+/* Find Byte [private]
+ *
+ * Search the readable bytes for byte, in at most two runs of memchr, and set
+ * position to the read position and used to the number of bytes searched.
+ * Returns the number of bytes up to and including the first occurrence, or 0
+ * if there is none.
+ */
+size_t
+find_byte(FIFO_T__TYPE *fifo, index_t *position, uint8_t byte, size_t *used)
+{
+  fifo__region_t regions[2];
+  uint8_t const *match;
+
+  *used = readable(fifo, position, SIZE_MAX);
+
+  if (*used == 0) {
+    return 0;
+  }
+
+  split(fifo, *position, *used, regions);
+
+  match = memchr(regions[0].data, byte, regions[0].len);
+
+  if (match != NULL) {
+    return (size_t) (match - regions[0].data) + 1;
+  }
+
+  match = memchr(regions[1].data, byte, regions[1].len);
+
+  if (match != NULL) {
+    return regions[0].len + (size_t) (match - regions[1].data) + 1;
+  }
+
+  return 0;
+}
+
+
+/* Not Found [private]
+ *
+ * Returns the result of a search that found nothing in used bytes:
+ * FIFO__FULL if those are all the fifo can hold, FIFO__EMPTY otherwise.
+ */
+fifo__result_t
+not_found(FIFO_T__TYPE const *fifo, size_t used)
+{
+  if (used > 0 && used == FIFO_T__FN(size)(fifo)) {
+    return FIFO__FULL;
+  }
+
+  return FIFO__EMPTY;
+}
+
+
+#ifdef FIFO__WAIT
+/* Wait [private]
+ *
+ * Wait until ready, readable or writable, reports at least len bytes. The
+ * fifo is checked FIFO__WAIT_SPIN times before the thread registers itself in
+ * waiters and sleeps on futex. The futex value is loaded before the last check,
+ * so a notification in between makes the sleep return at once. Returns
+ * timed_out if the timeout expires first.
+ */
+fifo__result_t
+wait(FIFO_T__TYPE *fifo, size_t (*ready)(FIFO_T__TYPE *, index_t *, size_t),
+     _Atomic(uint32_t) *futex, _Atomic(uint32_t) *waiters, size_t len,
+     int timeout_ms, fifo__result_t timed_out)
+{
+  struct timespec deadline;
+  index_t position;
+  size_t  i;
+
+  for (i = 0; i < FIFO__WAIT_SPIN; i ++) {
+    if (ready(fifo, &position, len) >= len) {
+      return FIFO__OK;
+    }
+  }
+
+  if (timeout_ms == 0) {
+    return timed_out;
+  }
+
+  if (timeout_ms > 0) {
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    deadline.tv_sec  += timeout_ms / 1000;
+    deadline.tv_nsec += (long) (timeout_ms % 1000) * 1000000;
+
+    if (deadline.tv_nsec >= 1000000000) {
+      deadline.tv_sec  += 1;
+      deadline.tv_nsec -= 1000000000;
+    }
+  }
+
+  for (;;) {
+    uint32_t value;
+    int      error;
+
+    /* Pairs with the barrier in fifo__futex_notify */
+    atomic_fetch_add_explicit(waiters, 1, memory_order_relaxed);
+    fifo__futex_barrier();
+    value = atomic_load_explicit(futex, memory_order_acquire);
+
+    if (ready(fifo, &position, len) >= len) {
+      atomic_fetch_sub_explicit(waiters, 1, memory_order_relaxed);
+
+      return FIFO__OK;
+    }
+
+    error = fifo__futex_wait(futex, value,
+                             timeout_ms < 0 ? NULL : &deadline);
+
+    atomic_fetch_sub_explicit(waiters, 1, memory_order_relaxed);
+
+    if (error == ETIMEDOUT) {
+      return ready(fifo, &position, len) >= len ? FIFO__OK : timed_out;
+    }
+  }
+}
+#endif
+
+
+#ifdef FIFO__NOTIFY
+/* Notify Data [private]
+ *
+ * Signal the data fd if the consumer asked for it. Called by the producer after
+ * storing the write cursor. The fence pairs with the one in arm_data, so that
+ * either the consumer sees the new data or this sees the flag.
+ */
+void
+notify_data(FIFO_T__TYPE *fifo)
+{
+  atomic_thread_fence(memory_order_seq_cst);
+
+  if (atomic_load_explicit(&fifo->data_armed, memory_order_relaxed) &&
+      atomic_exchange_explicit(&fifo->data_armed, 0, memory_order_relaxed)) {
+    fifo__notify_signal(fifo->data_fd);
+  }
+}
+
+
+/* Notify Space [private]
+ *
+ * Signal the space fd if the producer asked for it and at least the threshold
+ * of space is free. Called by the consumer after storing the read cursor, and
+ * by arm_space.
+ */
+void
+notify_space(FIFO_T__TYPE *fifo)
+{
+  index_t const mask = fifo->mask;
+
+  atomic_thread_fence(memory_order_seq_cst);
+
+  if (atomic_load_explicit(&fifo->space_armed, memory_order_relaxed)) {
+    cursor_t const read  = FIFO__LOAD(fifo, read,  acquire);
+    cursor_t const write = FIFO__LOAD(fifo, write, acquire);
+
+    if ((size_t) (mask | 0x01) + 1 - used_of(mask, read, write)
+          >= fifo->space_threshold &&
+        atomic_exchange_explicit(&fifo->space_armed, 0,
+                                 memory_order_relaxed)) {
+      fifo__notify_signal(fifo->space_fd);
+    }
+  }
+}
+
+
+/* Arm Data [private]
+ *
+ * Ask the producer to signal the data fd, after the consumer found the fifo
+ * empty at read. Data that arrived before the producer could see the request is
+ * signalled right away.
+ */
+void
+arm_data(FIFO_T__TYPE *fifo, cursor_t read)
+{
+  if (fifo->data_fd < 0 ||
+      atomic_load_explicit(&fifo->data_armed, memory_order_relaxed)) {
+    return;
+  }
+
+  atomic_store_explicit(&fifo->data_armed, 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+
+  if (FIFO__LOAD(fifo, write, acquire) != read) {
+    notify_data(fifo);
+  }
+}
+
+
+/* Arm Space [private]
+ *
+ * Ask the consumer to signal the space fd, after the producer found less than
+ * the threshold of space. Space freed before the consumer could see the request
+ * is signalled right away.
+ */
+void
+arm_space(FIFO_T__TYPE *fifo)
+{
+  if (fifo->space_fd < 0 ||
+      atomic_load_explicit(&fifo->space_armed, memory_order_relaxed)) {
+    return;
+  }
+
+  atomic_store_explicit(&fifo->space_armed, 1, memory_order_relaxed);
+  notify_space(fifo);
+}
+#endif
+
+
+#ifdef FIFO__STATS
+/* Statistics High Water [private]
+ *
+ * Raise the high water mark to the number of bytes used, if that is higher.
+ * Called by the producer after it committed a write. The read cursor is always
+ * loaded, as the cached copy of FIFO__CACHE_ALIGNED may be far behind and
+ * would make the mark climb with every write.
+ */
+void
+stats_high_water(FIFO_T__TYPE *fifo)
+{
+  cursor_t const read = FIFO__LOAD(fifo, read, relaxed);
+  uint64_t const used =
+    used_of(fifo->mask, read, FIFO__LOAD(fifo, write, relaxed));
+
+  if (used > FIFO__STAT_LOAD(fifo, producer_stats.high_water)) {
+    FIFO__STAT_STORE(fifo, producer_stats.high_water, used);
+  }
+}
+#endif
+
+
+/* Split [private]
+ *
+ * Describe len bytes starting at position as one region up to the edge of the
+ * buffer and one from the start of it. Returns len.
+ */
+size_t
+split(FIFO_T__TYPE const *fifo, index_t position, size_t len,
+      fifo__region_t regions[2])
+{
+  size_t const to_edge = (size_t) (fifo->mask | 0x01) + 1 - position;
+
+  regions[0].data = &fifo->buffer[position];
+  regions[1].data = fifo->buffer;
+
+  if (len < to_edge || FIFO__IS_MIRRORED(fifo)) {
+    regions[0].len = len;
+    regions[1].len = 0;
+  } else {
+    regions[0].len = to_edge;
+    regions[1].len = len - to_edge;
+  }
+
+  return len;
+}
+
+
+#ifdef __unix__
+/* To Iovec [private]
+ *
+ * Describe the regions returned by split as an iovec array.
+ */
+void
+to_iovec(fifo__region_t const regions[2], struct iovec iov[2])
+{
+  iov[0].iov_base = regions[0].data;
+  iov[0].iov_len  = regions[0].len;
+  iov[1].iov_base = regions[1].data;
+  iov[1].iov_len  = regions[1].len;
+}
+#endif
+
+
+/* Copy In [private]
+ *
+ * Copy len bytes into the buffer starting at position, wrapping around the
+ * edge of the buffer if needed.
+ */
+void
+copy_in(FIFO_T__TYPE *fifo, index_t position, uint8_t const *src, size_t len)
+{
+  size_t const to_edge = (size_t) (fifo->mask | 0x01) + 1 - position;
+
+  if (len < to_edge || FIFO__IS_MIRRORED(fifo)) {
+    copy(&fifo->buffer[position], src, len);
+  } else {
+    copy(&fifo->buffer[position], src, to_edge);
+    copy(fifo->buffer, src + to_edge, len - to_edge);
+  }
+}
+
+
+/* Copy Out [private]
+ *
+ * Copy len bytes out of the buffer starting at position, wrapping around the
+ * edge of the buffer if needed.
+ */
+void
+copy_out(FIFO_T__TYPE const *fifo, index_t position, uint8_t *dest,
+         size_t len)
+{
+  size_t const to_edge = (size_t) (fifo->mask | 0x01) + 1 - position;
+
+  if (len < to_edge || FIFO__IS_MIRRORED(fifo)) {
+    copy(dest, &fifo->buffer[position], len);
+  } else {
+    copy(dest, &fifo->buffer[position], to_edge);
+    copy(dest + to_edge, fifo->buffer, len - to_edge);
+  }
+}
+
+
+/* Write Runs [private]
+ *
+ * Copy len bytes into the buffer at position and commit them. Kept out of
+ * line, so the small paths of write do not pay for the registers of the copy.
+ */
+size_t
+write_runs(FIFO_T__TYPE *fifo, index_t position, uint8_t const *src,
+           size_t len)
+{
+  copy_in(fifo, position, src, len);
+  commit_write(fifo, len);
+
+  return len;
+}
+
+
+/* Read Runs [private]
+ *
+ * Copy len bytes out of the buffer at position and commit them, the
+ * counterpart of write_runs.
+ */
+size_t
+read_runs(FIFO_T__TYPE *fifo, index_t position, uint8_t *dest, size_t len)
+{
+  copy_out(fifo, position, dest, len);
+  commit_read(fifo, len);
+
+  return len;
+}
+
+
+/* Place [private]
+ *
+ * Set the mask and cursors to describe used bytes starting at index first.
+ */
+void
+place(FIFO_T__TYPE *fifo, index_t mask, index_t first, size_t used)
+{
+#ifdef FIFO__SPSC
+  fifo->mask = mask;
+  FIFO__STORE(fifo, read,  first, relaxed);
+  FIFO__STORE(fifo, write, first + (cursor_t) used, relaxed);
+  FIFO__CACHE(fifo, read,  first);
+  FIFO__CACHE(fifo, write, first + (cursor_t) used);
+#else
+  fifo->read  = first;
+  fifo->write = (first + used) & mask;
+
+  /* Mark buffer as full */
+  if (used == (size_t) mask + 1) {
+    FIFO__MARK_AS_FULL(mask);
+  }
+
+  fifo->mask = mask;
+#endif
+}
+
+
+/* Grow Buffer [private]
+ *
+ * Increase the size of the fifo. If the data wraps around the old edge of the
+ * buffer, the part at the start of the buffer is moved to just after the old
+ * edge. Since the new size is at least twice the old size it always fits.
+ */
+void
+grow_buffer(FIFO_T__TYPE *fifo, index_t first, size_t used)
+{
+  size_t const size    = (size_t) (fifo->mask | 0x01) + 1;
+  size_t const to_edge = size - first;
+
+  if (used > to_edge) {
+    memcpy(&fifo->buffer[size], fifo->buffer, used - to_edge);
+  }
+}
+
+
+/* Shrink Buffer [private]
+ *
+ * Decrease the size of the fifo. Returns the new index of the first byte.
+ *
+ * Every byte keeps its position modulo the new size, which means that only the
+ * bytes beyond the new edge need to be moved. These are the five different
+ * cases that need to be handled by the shrink function, shown on a size 8 fifo
+ * that is to be halved in size.
+ *
+ *   0 1 2 3 4 5 6 7    Comment
+ * A [ . . ]|W . . .    No moving of data required.
+ * B . . [ .|. ] W .    The upper half must be copied.
+ * C . . . .|[ . ] W    The entire buffer must be copied.
+ * D . ] W .|. . [ .    The lower half must be copied.
+ * E . [ . .|. . ] W    The buffer cannot be shrunk.
+ *
+ * Case E is rejected by the caller.
+ */
+index_t
+shrink_buffer(FIFO_T__TYPE *fifo, index_t first, size_t used, index_t mask)
+{
+  size_t const new_size = (size_t) mask + 1;
+  size_t const size     = (size_t) (fifo->mask | 0x01) + 1;
+  size_t       move_from;
+  size_t       move_end;
+
+  /* Only the run from first up to the old edge can lie beyond the new edge,
+     the wrapped part starts at 0 and is no longer than the new size. */
+  move_from = first;
+  move_end  = first + used;
+
+  if (move_end > size) {
+    move_end = size;
+  }
+
+  if (move_from < new_size) {
+    move_from = new_size;
+  }
+
+  while (move_from < move_end) {
+    size_t const move_to = move_from & mask;
+    size_t       copied  = new_size - move_to;
+
+    if (copied > move_end - move_from) {
+      copied = move_end - move_from;
+    }
+
+    memcpy(&fifo->buffer[move_to], &fifo->buffer[move_from], copied);
+    move_from += copied;
+  }
+
+  return first & mask;
+}
+
+/* Copy [private]
+ *
+ * Copy one contiguous run of bytes to or from the buffer.
+ */
+void
+copy(uint8_t *dest, uint8_t const *src, size_t len)
+{
+  if (len >= FIFO__SHORT_COPY) {
+    memcpy(dest, src, len);
+  } else {
+    copy_short(dest, src, len);
+  }
+}
+
+
+/* Copy Short [private]
+ *
+ * Copy a run of less than FIFO__SHORT_COPY bytes in fixed size steps, one for
+ * each bit set in len.
+ */
+void
+copy_short(uint8_t *dest, uint8_t const *src, size_t len)
+{
+  FIFO__COPY_STEP(dest, src, len, 16);
+  FIFO__COPY_STEP(dest, src, len, 8);
+  FIFO__COPY_STEP(dest, src, len, 4);
+  FIFO__COPY_STEP(dest, src, len, 2);
+  FIFO__COPY_STEP(dest, src, len, 1);
+}
+
+/* Size to Mask [private]
+ *
+ * Returns the mask of the largest power of 2 that fits in size. Sizes smaller
+ * than FIFO__SIZE_MIN are not supported and result in a mask of 0.
+ */
+index_t
+size_to_mask(size_t size)
+{
+  if (size < FIFO__SIZE_MIN) {
+    return 0;
+  }
+
+  return (index_t) fifo__size_to_mask(size);
+}
+
+#undef FIFO__MARK_AS_FULL
+#undef FIFO__IS_ZERO_SIZE
+#undef FIFO__IS_MIRRORED
+#undef FIFO__LOAD
+#undef FIFO__STORE
+#undef FIFO__CACHE
+#undef FIFO__STAT_LOAD
+#undef FIFO__STAT_STORE
+#undef FIFO__STAT_ADD
+#undef FIFO__SHORT_COPY
+#undef FIFO__BYTE_COPY
+#undef FIFO__COPY_STEP
+#undef FIFO__WAIT_SPIN
+#undef FIFO_T__NAME
+#undef FIFO_T__INDEX
+#undef FIFO_T__CURSOR
+#undef FIFO_T__MIRROR
+#undef FIFO_T__SIZE_MAX
@@ -0,0 +1,98 @@
+#ifdef __linux__
+
+#define _GNU_SOURCE
+
+#include <fifo_mirror.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "fifo_private.h"
+
+/* Function Definitions ----------------------------------------------------- */
+
+/* Initialize a new mirrored buffer.
+ *
+ * The size is rounded up to the nearest power of 2 that is also a multiple of
+ * the page size. Returns FIFO__INVALID_SIZE if the size is above
+ * FIFO_MIRROR__SIZE_MAX, and FIFO__SYSTEM_ERROR, with errno set, if the memory
+ * could not be mapped.
+ */
+fifo__result_t
+fifo_mirror__ctor(fifo_mirror_t *mirror, size_t size)
+{
+  size_t   const page_size = (size_t) sysconf(_SC_PAGESIZE);
+  uint8_t *area;
+  int      fd;
+  int      error;
+
+  if (size < page_size) {
+    size = page_size;
+  }
+
+  /* Both views have to fit in the address space */
+  if (size > FIFO_MIRROR__SIZE_MAX) {
+    return FIFO__INVALID_SIZE;
+  }
+
+  /* Round up to a power of 2 */
+  if (size & (size - 1)) {
+    size = (fifo__size_to_mask(size) + 1) << 1;
+  }
+
+  fd = memfd_create("fifo_mirror", MFD_CLOEXEC);
+
+  if (fd < 0) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  if (ftruncate(fd, size) != 0) {
+    goto fifo_mirror__ctor__close;
+  }
+
+  /* Reserve room for both mappings, then place them on top of it. */
+  area = mmap(NULL, size << 1, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (area == MAP_FAILED) {
+    goto fifo_mirror__ctor__close;
+  }
+
+  if (mmap(area, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+           fd, 0) == MAP_FAILED ||
+      mmap(area + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+           fd, 0) == MAP_FAILED) {
+    munmap(area, size << 1);
+    goto fifo_mirror__ctor__close;
+  }
+
+  /* The mappings keep the memory alive */
+  close(fd);
+
+  mirror->buffer = area;
+  mirror->size   = size;
+
+  return FIFO__OK;
+
+fifo_mirror__ctor__close:
+  error = errno;
+  close(fd);
+  errno = error;
+
+  return FIFO__SYSTEM_ERROR;
+}
+
+
+/* Destroy a mirrored buffer, unmapping both views.
+ */
+void
+fifo_mirror__dtor(fifo_mirror_t *mirror)
+{
+  if (mirror->buffer != NULL) {
+    munmap(mirror->buffer, mirror->size << 1);
+  }
+
+  mirror->buffer = NULL;
+  mirror->size   = 0;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,186 @@
+#include <fifo_mpmc.h>
+
+#include "fifo_private.h"
+
+/* Notes:
+ * Slot i starts out with sequence i. A producer that has claimed position p
+ * may write to slot p & mask once its sequence equals p, and publishes the
+ * element by setting the sequence to p + 1. A consumer that has claimed
+ * position p may read the slot once its sequence equals p + 1, and hands it
+ * back to the producers of the next lap by setting it to p + size.
+ *
+ * Comparing the sequence with the position as a signed difference tells a
+ * thread whether the slot is ready (0), still in use by the previous lap
+ * (negative, so the queue is full or empty) or already claimed by another
+ * thread (positive, so the position must be reloaded).
+ */
+
+/* Private Functions -------------------------------------------------------- */
+
+static inline fifo_mpmc__slot_t *
+  slot(fifo_mpmc_t const *fifo, size_t position);
+
+
+/* Function Definitions ----------------------------------------------------- */
+
+/* Initialize a new MPMC queue.
+ *
+ * The buffer must be aligned for size_t and hold FIFO_MPMC__BUFFER_SIZE(size,
+ * element_size) bytes.
+ */
+void
+fifo_mpmc__ctor(fifo_mpmc_t *fifo, void *buffer, size_t size,
+                size_t element_size)
+{
+  size_t i;
+
+  assert(size >= FIFO_MPMC__SIZE_MIN);
+  assert(element_size > 0);
+  assert(((uintptr_t) buffer & (sizeof(fifo_mpmc__slot_t) - 1)) == 0);
+
+  WRITE_CONST(fifo->buffer, uint8_t*, buffer);
+  fifo->mask         = fifo__size_to_mask(size);
+  fifo->element_size = element_size;
+  fifo->slot_size    = FIFO_MPMC__SLOT_SIZE(element_size);
+
+  for (i = 0; i <= fifo->mask; i ++) {
+    atomic_init(&slot(fifo, i)->sequence, i);
+  }
+
+  atomic_init(&fifo->enqueue, 0);
+  atomic_init(&fifo->dequeue, 0);
+}
+
+
+/* Size
+ *
+ * Returns the number of slots in the queue.
+ */
+size_t
+fifo_mpmc__size(fifo_mpmc_t const *fifo)
+{
+  return fifo->mask + 1;
+}
+
+
+/* Used
+ *
+ * Returns the number of claimed slots. Since other threads may be active the
+ * result is only a snapshot.
+ */
+size_t
+fifo_mpmc__used(fifo_mpmc_t const *fifo)
+{
+  size_t const dequeue =
+    atomic_load_explicit(&fifo->dequeue, memory_order_relaxed);
+  size_t const enqueue =
+    atomic_load_explicit(&fifo->enqueue, memory_order_relaxed);
+  ptrdiff_t const used = (ptrdiff_t) (enqueue - dequeue);
+
+  if (used < 0) {
+    return 0;
+  } else if ((size_t) used > fifo->mask) {
+    return fifo->mask + 1;
+  }
+
+  return used;
+}
+
+
+/* Write
+ *
+ * Copy one element into the queue. Returns non-zero if there was room for it.
+ */
+bool_t
+fifo_mpmc__write(fifo_mpmc_t *fifo, void const *src)
+{
+  fifo_mpmc__slot_t *cell;
+  size_t position =
+    atomic_load_explicit(&fifo->enqueue, memory_order_relaxed);
+
+  for (;;) {
+    size_t    sequence;
+    ptrdiff_t diff;
+
+    cell     = slot(fifo, position);
+    sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    diff     = (ptrdiff_t) (sequence - position);
+
+    if (diff == 0) {
+      /* The slot is free, try to claim it */
+      if (atomic_compare_exchange_weak_explicit(&fifo->enqueue, &position,
+                                                position + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      /* Full */
+      return 0;
+    } else {
+      position = atomic_load_explicit(&fifo->enqueue, memory_order_relaxed);
+    }
+  }
+
+  memcpy(cell + 1, src, fifo->element_size);
+  atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+
+  return 1;
+}
+
+
+/* Read
+ *
+ * Copy one element out of the queue. Returns non-zero if there was one.
+ */
+bool_t
+fifo_mpmc__read(fifo_mpmc_t *fifo, void *dest)
+{
+  fifo_mpmc__slot_t *cell;
+  size_t position =
+    atomic_load_explicit(&fifo->dequeue, memory_order_relaxed);
+
+  for (;;) {
+    size_t    sequence;
+    ptrdiff_t diff;
+
+    cell     = slot(fifo, position);
+    sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    diff     = (ptrdiff_t) (sequence - (position + 1));
+
+    if (diff == 0) {
+      /* The slot holds an element, try to claim it */
+      if (atomic_compare_exchange_weak_explicit(&fifo->dequeue, &position,
+                                                position + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      /* Empty */
+      return 0;
+    } else {
+      position = atomic_load_explicit(&fifo->dequeue, memory_order_relaxed);
+    }
+  }
+
+  memcpy(dest, cell + 1, fifo->element_size);
+  atomic_store_explicit(&cell->sequence, position + fifo->mask + 1,
+                        memory_order_release);
+
+  return 1;
+}
+
+
+/* Private Function Definitions --------------------------------------------- */
+
+/* Slot [private]
+ *
+ * Returns the slot used by the given position.
+ */
+fifo_mpmc__slot_t *
+slot(fifo_mpmc_t const *fifo, size_t position)
+{
+  return (fifo_mpmc__slot_t *)
+    &fifo->buffer[(position & fifo->mask) * fifo->slot_size];
+}
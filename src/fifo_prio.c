@@ -0,0 +1,172 @@
+#include <fifo_prio.h>
+
+#include "fifo_private.h"
+
+/* Private Functions -------------------------------------------------------- */
+
+static inline size_t
+  lowest(uint32_t bits) PURE;
+
+static void
+  new_round(fifo_prio_t *prio);
+
+
+/* Function Definitions ----------------------------------------------------- */
+
+/* Initialize a new priority fifo without lanes, see fifo_prio__lane_ctor.
+ */
+void
+fifo_prio__ctor(fifo_prio_t *prio, fifo_prio__policy_t policy)
+{
+  prio->policy   = policy;
+  prio->lanes    = 0;
+  prio->used     = 0;
+  prio->credited = 0;
+}
+
+
+/* Lane Constructor
+ *
+ * Set up the given lane on a buffer of size bytes, see fifo32__ctor. The
+ * weight is the number of messages the lane may deliver per round under
+ * FIFO_PRIO__WEIGHTED, and is ignored under FIFO_PRIO__STRICT. Returns
+ * FIFO__INVALID_SIZE if the lane number, size or weight is out of range.
+ */
+fifo__result_t
+fifo_prio__lane_ctor(fifo_prio_t *prio, size_t lane, void *buffer, size_t size,
+                     uint32_t weight)
+{
+  uint32_t bit;
+
+  if (lane >= FIFO_PRIO__LANES_MAX || size < FIFO__SIZE_MIN ||
+      size > FIFO32__SIZE_MAX || weight == 0) {
+    return FIFO__INVALID_SIZE;
+  }
+
+  bit = (uint32_t) 1 << lane;
+
+  fifo32__ctor(&prio->lane[lane].fifo, buffer, size);
+  prio->lane[lane].weight = weight;
+  prio->lane[lane].credit = weight;
+
+  prio->lanes    |= bit;
+  prio->used     &= ~bit;
+  prio->credited |= bit;
+
+  return FIFO__OK;
+}
+
+
+bool_t
+fifo_prio__is_empty(fifo_prio_t const *prio)
+{
+  return prio->used == 0;
+}
+
+
+/* Push
+ *
+ * Add a message to the given lane, see fifo32__push_msg for the results.
+ */
+fifo__result_t
+fifo_prio__push(fifo_prio_t *prio, size_t lane, void const *src, size_t len)
+{
+  fifo__result_t res;
+
+  assert(lane < FIFO_PRIO__LANES_MAX);
+  assert(prio->lanes & ((uint32_t) 1 << lane));
+
+  res = fifo32__push_msg(&prio->lane[lane].fifo, src, len);
+
+  if (res == FIFO__OK) {
+    prio->used |= (uint32_t) 1 << lane;
+  }
+
+  return res;
+}
+
+
+/* Pop
+ *
+ * Read the next message according to the policy into dest, which can hold
+ * size bytes, and set len to its length and lane to the lane it came from.
+ * Returns FIFO__EMPTY if no lane holds a message. If the message is larger
+ * than size, FIFO__INVALID_SIZE is returned and it is left in its lane, with
+ * len and lane still set.
+ */
+fifo__result_t
+fifo_prio__pop(fifo_prio_t *prio, void *dest, size_t size, size_t *len,
+               size_t *lane)
+{
+  uint32_t           candidates = prio->used;
+  fifo_prio__lane_t *chosen;
+  fifo__result_t     res;
+  uint32_t           bit;
+
+  if (candidates == 0) {
+    return FIFO__EMPTY;
+  }
+
+  if (prio->policy == FIFO_PRIO__WEIGHTED) {
+    candidates &= prio->credited;
+
+    if (candidates == 0) {
+      new_round(prio);
+      candidates = prio->used;
+    }
+  }
+
+  *lane  = lowest(candidates);
+  bit    = (uint32_t) 1 << *lane;
+  chosen = &prio->lane[*lane];
+
+  res = fifo32__pop_msg(&chosen->fifo, dest, size, len);
+
+  if (res != FIFO__OK) {
+    return res;
+  }
+
+  if (fifo32__is_empty(&chosen->fifo)) {
+    prio->used &= ~bit;
+  }
+
+  if (prio->policy == FIFO_PRIO__WEIGHTED && -- chosen->credit == 0) {
+    prio->credited &= ~bit;
+  }
+
+  return FIFO__OK;
+}
+
+
+/* Private Function Definitions --------------------------------------------- */
+
+
+/* Lowest [private]
+ *
+ * Returns the index of the lowest set bit, bits must not be 0.
+ */
+size_t
+lowest(uint32_t bits)
+{
+  return (size_t) __builtin_ctz(bits);
+}
+
+
+/* New Round [private]
+ *
+ * Give every lane its full weight again.
+ */
+void
+new_round(fifo_prio_t *prio)
+{
+  uint32_t lanes = prio->lanes;
+
+  while (lanes != 0) {
+    size_t const lane = lowest(lanes);
+
+    prio->lane[lane].credit = prio->lane[lane].weight;
+    lanes &= lanes - 1;
+  }
+
+  prio->credited = prio->lanes;
+}
@@ -0,0 +1,139 @@
+/* Fifo Private
+ *
+ * Helpers shared by the fifo implementations. Not part of the public API.
+ */
+
+#ifndef FIFO_PRIVATE_H
+#define FIFO_PRIVATE_H 1
+
+/* Includes ----------------------------------------------------------------- */
+
+#include <compiler.h>
+#include <fifo.h>
+
+#ifdef __unix__
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#ifdef FIFO__NOTIFY
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+#ifdef FIFO__WAIT
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+
+/* Largest number of bytes needed to encode a size_t as a varint. */
+#define FIFO__VARINT_MAX                          ((sizeof(size_t) * 8 + 6) / 7)
+
+
+/* Function Declarations ---------------------------------------------------- */
+
+uint32_t
+  fifo__crc32c_copy(uint32_t crc, void *dest, void const *src, size_t len)
+  NONNULL;
+
+#ifdef FIFO__WAIT
+extern _Atomic(int) fifo__futex_membarrier;
+
+void
+  fifo__futex_setup(void);
+
+void
+  fifo__futex_barrier(void);
+#endif
+
+
+/* Inline Function Definitions ---------------------------------------------- */
+
+/* Varint Encode
+ *
+ * Write value to dest as a varint, 7 bits per byte starting with the lowest,
+ * with the top bit set on every byte but the last. dest must have room for
+ * FIFO__VARINT_MAX bytes. Returns the number of bytes written.
+ */
+static inline size_t
+fifo__varint_encode(size_t value, uint8_t *dest)
+{
+  size_t len = 0;
+
+  while (value >= 0x80) {
+    dest[len ++] = (uint8_t) (value | 0x80);
+    value >>= 7;
+  }
+
+  dest[len ++] = (uint8_t) value;
+
+  return len;
+}
+
+#ifdef FIFO__WAIT
+/* Futex Wait
+ *
+ * Sleep on futex as long as it holds value, until it is woken or the absolute
+ * CLOCK_MONOTONIC deadline passes. A NULL deadline waits forever. Returns 0
+ * when woken and otherwise the error, e.g. ETIMEDOUT, EAGAIN if the value had
+ * already changed or EINTR. The futex is private to the process, as is the
+ * barrier of fifo__futex_barrier.
+ */
+static inline int
+fifo__futex_wait(_Atomic(uint32_t) *futex, uint32_t value,
+                 struct timespec const *deadline)
+{
+  if (syscall(SYS_futex, futex, FUTEX_WAIT_BITSET_PRIVATE, value, deadline, NULL,
+              FUTEX_BITSET_MATCH_ANY) != 0) {
+    return errno;
+  }
+
+  return 0;
+}
+
+/* Futex Notify
+ *
+ * Wake the threads sleeping on futex, if waiters says there are any. Must be
+ * called after the cursor change they wait for has been stored. The barrier
+ * pairs with fifo__futex_barrier after the increment of waiters in a waiting
+ * thread, so that either the waiter sees the new cursor or this sees the
+ * waiter. With membarrier it only has to stop the compiler, so a commit
+ * without waiters costs one more load.
+ */
+static inline void
+fifo__futex_notify(_Atomic(uint32_t) *futex, _Atomic(uint32_t) *waiters)
+{
+  if (atomic_load_explicit(&fifo__futex_membarrier,
+                           memory_order_relaxed) == 1) {
+    atomic_signal_fence(memory_order_seq_cst);
+  } else {
+    atomic_thread_fence(memory_order_seq_cst);
+  }
+
+  if (atomic_load_explicit(waiters, memory_order_relaxed) != 0) {
+    atomic_fetch_add_explicit(futex, 1, memory_order_release);
+    syscall(SYS_futex, futex, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+  }
+}
+#endif
+
+#ifdef FIFO__NOTIFY
+/* Notify Signal
+ *
+ * Make the given eventfd readable. The counter of the eventfd only matters as
+ * far as it is non-zero, so failures to add to it are ignored.
+ */
+static inline void
+fifo__notify_signal(int fd)
+{
+  eventfd_write(fd, 1);
+}
+#endif
+
+#endif /* FIFO_PRIVATE_H */
@@ -0,0 +1,302 @@
+#include <fifo_seg.h>
+#include <stdlib.h>
+
+#include "fifo_private.h"
+
+/* Private Functions -------------------------------------------------------- */
+
+static inline uint8_t *
+  data(fifo_seg__segment_t *segment);
+
+static inline fifo_seg__segment_t *
+  take(fifo_seg__pool_t *pool);
+
+static inline void
+  give(fifo_seg__pool_t *pool, fifo_seg__segment_t *segment);
+
+
+/* Function Definitions ----------------------------------------------------- */
+
+/* Initialize a new, empty pool of segments holding segment_size bytes each.
+ *
+ * At most limit segments are allocated, or any number if limit is 0.
+ */
+void
+fifo_seg__pool_ctor(fifo_seg__pool_t *pool, size_t segment_size, size_t limit)
+{
+  assert(segment_size > 0);
+
+  pool->free         = NULL;
+  pool->segment_size = segment_size;
+  pool->limit        = limit;
+  pool->allocated    = 0;
+  pool->available    = 0;
+}
+
+
+/* Reserve
+ *
+ * Allocate segments until at least count of them are on the free list.
+ * Returns FIFO__INVALID_SIZE if that would exceed the limit, and
+ * FIFO__SYSTEM_ERROR if memory ran out. Segments allocated before a failure are
+ * kept.
+ */
+fifo__result_t
+fifo_seg__pool_reserve(fifo_seg__pool_t *pool, size_t count)
+{
+  while (pool->available < count) {
+    fifo_seg__segment_t *segment;
+
+    if (pool->limit != 0 && pool->allocated == pool->limit) {
+      return FIFO__INVALID_SIZE;
+    }
+
+    segment = malloc(sizeof(fifo_seg__segment_t) + pool->segment_size);
+
+    if (segment == NULL) {
+      return FIFO__SYSTEM_ERROR;
+    }
+
+    pool->allocated ++;
+    give(pool, segment);
+  }
+
+  return FIFO__OK;
+}
+
+
+/* Destroy a pool, freeing the segments on its free list.
+ *
+ * The fifos using the pool must be destroyed first, otherwise their segments
+ * are leaked.
+ */
+void
+fifo_seg__pool_dtor(fifo_seg__pool_t *pool)
+{
+  assert(pool->allocated == pool->available);
+
+  while (pool->free != NULL) {
+    fifo_seg__segment_t * const next = pool->free->next;
+
+    free(pool->free);
+    pool->free = next;
+  }
+
+  pool->allocated = 0;
+  pool->available = 0;
+}
+
+
+/* Initialize a new, empty fifo taking its segments from pool.
+ */
+void
+fifo_seg__ctor(fifo_seg_t *fifo, fifo_seg__pool_t *pool)
+{
+  fifo->pool  = pool;
+  fifo->head  = NULL;
+  fifo->tail  = NULL;
+  fifo->read  = 0;
+  fifo->write = 0;
+  fifo->used  = 0;
+}
+
+
+/* Destroy a fifo, returning all of its segments to the pool.
+ */
+void
+fifo_seg__dtor(fifo_seg_t *fifo)
+{
+  fifo_seg__flush(fifo);
+}
+
+
+/* Used
+ *
+ * Returns the number of bytes in the fifo.
+ */
+size_t
+fifo_seg__used(fifo_seg_t const *fifo)
+{
+  return fifo->used;
+}
+
+
+bool_t
+fifo_seg__is_empty(fifo_seg_t const *fifo)
+{
+  return fifo->used == 0;
+}
+
+
+/* Write
+ *
+ * Append len bytes, adding segments as needed. Returns the number of bytes
+ * written, which is only less than len if the pool could not provide another
+ * segment.
+ */
+size_t
+fifo_seg__write(fifo_seg_t *fifo, void const *src, size_t len)
+{
+  size_t const   segment_size = fifo->pool->segment_size;
+  uint8_t const *src_buffer   = src;
+  size_t         written      = 0;
+
+  while (written < len) {
+    size_t chunk;
+
+    if (fifo->tail == NULL || fifo->write == segment_size) {
+      fifo_seg__segment_t * const segment = take(fifo->pool);
+
+      if (segment == NULL) {
+        break;
+      }
+
+      if (fifo->tail == NULL) {
+        fifo->head = segment;
+        fifo->read = 0;
+      } else {
+        fifo->tail->next = segment;
+      }
+
+      fifo->tail  = segment;
+      fifo->write = 0;
+    }
+
+    chunk = segment_size - fifo->write;
+
+    if (chunk > len - written) {
+      chunk = len - written;
+    }
+
+    memcpy(data(fifo->tail) + fifo->write, src_buffer + written, chunk);
+    fifo->write += chunk;
+    written     += chunk;
+  }
+
+  fifo->used += written;
+
+  return written;
+}
+
+
+/* Read
+ *
+ * Read up to len bytes, returning each segment to the pool once it has been
+ * read completely. Returns the number of bytes read.
+ */
+size_t
+fifo_seg__read(fifo_seg_t *fifo, void *dest, size_t len)
+{
+  size_t const segment_size = fifo->pool->segment_size;
+  uint8_t     *dest_buffer  = dest;
+  size_t       read         = 0;
+
+  if (len > fifo->used) {
+    len = fifo->used;
+  }
+
+  while (read < len) {
+    size_t const end = fifo->head == fifo->tail ? fifo->write : segment_size;
+    size_t       chunk = end - fifo->read;
+
+    if (chunk > len - read) {
+      chunk = len - read;
+    }
+
+    memcpy(dest_buffer + read, data(fifo->head) + fifo->read, chunk);
+    fifo->read += chunk;
+    read       += chunk;
+
+    if (fifo->read == end && fifo->head != fifo->tail) {
+      fifo_seg__segment_t * const next = fifo->head->next;
+
+      give(fifo->pool, fifo->head);
+      fifo->head = next;
+      fifo->read = 0;
+    }
+  }
+
+  fifo->used -= read;
+
+  /* Start the last segment over rather than letting it run full */
+  if (fifo->used == 0) {
+    fifo->read  = 0;
+    fifo->write = 0;
+  }
+
+  return read;
+}
+
+
+/* Flush
+ *
+ * Remove all bytes and return every segment to the pool.
+ */
+void
+fifo_seg__flush(fifo_seg_t *fifo)
+{
+  while (fifo->head != NULL) {
+    fifo_seg__segment_t * const next = fifo->head->next;
+
+    give(fifo->pool, fifo->head);
+    fifo->head = next;
+  }
+
+  fifo->tail  = NULL;
+  fifo->read  = 0;
+  fifo->write = 0;
+  fifo->used  = 0;
+}
+
+
+/* Private Function Definitions --------------------------------------------- */
+
+
+/* Data [private]
+ *
+ * Returns the data that follows the header of a segment.
+ */
+uint8_t *
+data(fifo_seg__segment_t *segment)
+{
+  return (uint8_t *) (segment + 1);
+}
+
+
+/* Take [private]
+ *
+ * Returns a segment from the free list, or a newly allocated one if the list
+ * is empty. Returns NULL if the limit was reached or memory ran out.
+ */
+fifo_seg__segment_t *
+take(fifo_seg__pool_t *pool)
+{
+  fifo_seg__segment_t *segment = pool->free;
+
+  if (segment == NULL) {
+    if (fifo_seg__pool_reserve(pool, 1) != FIFO__OK) {
+      return NULL;
+    }
+
+    segment = pool->free;
+  }
+
+  pool->free = segment->next;
+  pool->available --;
+  segment->next = NULL;
+
+  return segment;
+}
+
+
+/* Give [private]
+ *
+ * Put a segment on the free list.
+ */
+void
+give(fifo_seg__pool_t *pool, fifo_seg__segment_t *segment)
+{
+  segment->next = pool->free;
+  pool->free    = segment;
+  pool->available ++;
+}
@@ -0,0 +1,350 @@
+#ifdef __unix__
+
+#include <fifo_shm.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fifo_private.h"
+
+/* Notes:
+ * The creator initializes the header before it stores the magic number with
+ * release semantics, and attach loads it with acquire semantics, so a process
+ * that sees the magic also sees the size and offset. Before that the object
+ * may still be empty or partially initialized, which attach reports as EAGAIN.
+ *
+ * Cursors are 64 bit in every process, so that a 32 bit process can share a
+ * fifo with a 64 bit one. Lock free 64 bit atomics are required, as locks of
+ * the C library would not be shared between the processes.
+ */
+
+_Static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+               "fifo_shm needs lock free 64 bit atomics");
+
+
+/* Private Functions -------------------------------------------------------- */
+
+static inline fifo__result_t
+  map(fifo_shm_t *fifo, int fd, size_t len);
+
+
+/* Function Definitions ----------------------------------------------------- */
+
+/* Create
+ *
+ * Create a new shared memory object of the given name holding an empty fifo,
+ * and attach to it. The size is rounded up to a power of 2. Returns
+ * FIFO__SYSTEM_ERROR, with errno set, if the object already exists or could
+ * not be created.
+ */
+fifo__result_t
+fifo_shm__create(fifo_shm_t *fifo, char const *name, size_t size)
+{
+  size_t const offset = sizeof(fifo_shm__header_t);
+  fifo_shm__header_t *header;
+  int fd;
+  int error;
+
+  if (size < FIFO__SIZE_MIN) {
+    size = FIFO__SIZE_MIN;
+  }
+
+  /* Round up to a power of 2 */
+  if (size & (size - 1)) {
+    if (size > FIFOSZ__SIZE_MAX) {
+      return FIFO__INVALID_SIZE;
+    }
+
+    size = (fifo__size_to_mask(size) + 1) << 1;
+  }
+
+  if (size > SIZE_MAX - offset) {
+    return FIFO__INVALID_SIZE;
+  }
+
+  fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+  if (fd < 0) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  if (ftruncate(fd, (off_t) (offset + size)) != 0 ||
+      map(fifo, fd, offset + size) != FIFO__OK) {
+    error = errno;
+    close(fd);
+    shm_unlink(name);
+    errno = error;
+
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  close(fd);
+
+  header         = fifo->header;
+  header->size   = size;
+  header->offset = offset;
+  atomic_store_explicit(&header->write, 0, memory_order_relaxed);
+  atomic_store_explicit(&header->read,  0, memory_order_relaxed);
+
+  fifo->buffer      = (uint8_t *) header + offset;
+  fifo->mask        = size - 1;
+  fifo->read_cache  = 0;
+  fifo->write_cache = 0;
+
+  atomic_store_explicit(&header->magic, FIFO_SHM__MAGIC, memory_order_release);
+
+  return FIFO__OK;
+}
+
+
+/* Attach
+ *
+ * Map the fifo in the shared memory object of the given name into this
+ * process. Returns FIFO__SYSTEM_ERROR, with errno set, if there is no such
+ * object, EAGAIN if its creator has not finished initializing it yet, or
+ * EINVAL if it does not hold a valid fifo.
+ */
+fifo__result_t
+fifo_shm__attach(fifo_shm_t *fifo, char const *name)
+{
+  fifo_shm__header_t *header;
+  struct stat         st;
+  uint32_t            magic;
+  int                 fd;
+  int                 error;
+
+  fd = shm_open(name, O_RDWR, 0);
+
+  if (fd < 0) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  if (fstat(fd, &st) != 0) {
+    goto fifo_shm__attach__close;
+  }
+
+  if ((size_t) st.st_size < sizeof(fifo_shm__header_t)) {
+    errno = EAGAIN;
+    goto fifo_shm__attach__close;
+  }
+
+  if (map(fifo, fd, (size_t) st.st_size) != FIFO__OK) {
+    goto fifo_shm__attach__close;
+  }
+
+  close(fd);
+
+  header = fifo->header;
+  magic  = atomic_load_explicit(&header->magic, memory_order_acquire);
+
+  if (magic != FIFO_SHM__MAGIC) {
+    fifo_shm__detach(fifo);
+    errno = magic == 0 ? EAGAIN : EINVAL;
+
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  /* Do not trust the header further than the mapping reaches */
+  if (header->size < FIFO__SIZE_MIN ||
+      (header->size & (header->size - 1)) != 0 ||
+      header->offset < sizeof(fifo_shm__header_t) ||
+      header->offset > fifo->mapped ||
+      header->size > fifo->mapped - header->offset) {
+    fifo_shm__detach(fifo);
+    errno = EINVAL;
+
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  fifo->buffer      = (uint8_t *) header + header->offset;
+  fifo->mask        = header->size - 1;
+  fifo->read_cache  = atomic_load_explicit(&header->read, memory_order_acquire);
+  fifo->write_cache = atomic_load_explicit(&header->write,
+                                           memory_order_acquire);
+
+  return FIFO__OK;
+
+fifo_shm__attach__close:
+  error = errno;
+  close(fd);
+  errno = error;
+
+  return FIFO__SYSTEM_ERROR;
+}
+
+
+/* Detach
+ *
+ * Unmap the fifo from this process. The shared memory object remains until it
+ * is unlinked and every process has detached.
+ */
+void
+fifo_shm__detach(fifo_shm_t *fifo)
+{
+  if (fifo->header != NULL) {
+    munmap(fifo->header, fifo->mapped);
+  }
+
+  fifo->header = NULL;
+  fifo->buffer = NULL;
+  fifo->mask   = 0;
+  fifo->mapped = 0;
+}
+
+
+/* Unlink
+ *
+ * Remove the name of a shared memory object, so that no further process can
+ * attach to it. Returns FIFO__SYSTEM_ERROR, with errno set, on failure.
+ */
+fifo__result_t
+fifo_shm__unlink(char const *name)
+{
+  if (shm_unlink(name) != 0) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  return FIFO__OK;
+}
+
+
+/* Size
+ *
+ * Returns the number of bytes the fifo can hold.
+ */
+size_t
+fifo_shm__size(fifo_shm_t const *fifo)
+{
+  return fifo->mask + 1;
+}
+
+
+/* Used
+ *
+ * Returns the number of bytes in the fifo.
+ */
+size_t
+fifo_shm__used(fifo_shm_t const *fifo)
+{
+  /* Load read first, write can only have moved further ahead of it */
+  uint64_t const read = atomic_load_explicit(&fifo->header->read,
+                                             memory_order_acquire);
+
+  return atomic_load_explicit(&fifo->header->write, memory_order_acquire)
+    - read;
+}
+
+
+/* Available
+ *
+ * Returns the number of free bytes.
+ */
+size_t
+fifo_shm__available(fifo_shm_t const *fifo)
+{
+  return fifo_shm__size(fifo) - fifo_shm__used(fifo);
+}
+
+
+/* Write
+ *
+ * Write up to len bytes. Returns the number of bytes written. Must only be
+ * called by the producing process.
+ */
+size_t
+fifo_shm__write(fifo_shm_t *fifo, void const *src, size_t len)
+{
+  fifo_shm__header_t * const header = fifo->header;
+  uint64_t const write = atomic_load_explicit(&header->write,
+                                              memory_order_relaxed);
+  size_t const position  = write & fifo->mask;
+  size_t const to_edge   = fifo->mask + 1 - position;
+  size_t       available = fifo->mask + 1 - (write - fifo->read_cache);
+
+  if (len > available) {
+    fifo->read_cache = atomic_load_explicit(&header->read,
+                                            memory_order_acquire);
+    available        = fifo->mask + 1 - (write - fifo->read_cache);
+
+    if (len > available) {
+      len = available;
+    }
+  }
+
+  if (len <= to_edge) {
+    memcpy(&fifo->buffer[position], src, len);
+  } else {
+    memcpy(&fifo->buffer[position], src, to_edge);
+    memcpy(fifo->buffer, (uint8_t const *) src + to_edge, len - to_edge);
+  }
+
+  atomic_store_explicit(&header->write, write + len, memory_order_release);
+
+  return len;
+}
+
+
+/* Read
+ *
+ * Read up to len bytes. Returns the number of bytes read. Must only be called
+ * by the consuming process.
+ */
+size_t
+fifo_shm__read(fifo_shm_t *fifo, void *dest, size_t len)
+{
+  fifo_shm__header_t * const header = fifo->header;
+  uint64_t const read = atomic_load_explicit(&header->read,
+                                             memory_order_relaxed);
+  size_t const position = read & fifo->mask;
+  size_t const to_edge  = fifo->mask + 1 - position;
+  size_t       used     = fifo->write_cache - read;
+
+  if (len > used) {
+    fifo->write_cache = atomic_load_explicit(&header->write,
+                                             memory_order_acquire);
+    used              = fifo->write_cache - read;
+
+    if (len > used) {
+      len = used;
+    }
+  }
+
+  if (len <= to_edge) {
+    memcpy(dest, &fifo->buffer[position], len);
+  } else {
+    memcpy(dest, &fifo->buffer[position], to_edge);
+    memcpy((uint8_t *) dest + to_edge, fifo->buffer, len - to_edge);
+  }
+
+  atomic_store_explicit(&header->read, read + len, memory_order_release);
+
+  return len;
+}
+
+
+/* Private Function Definitions --------------------------------------------- */
+
+
+/* Map [private]
+ *
+ * Map len bytes of the shared memory object fd into the handle. Returns
+ * FIFO__SYSTEM_ERROR, with errno set, on failure.
+ */
+fifo__result_t
+map(fifo_shm_t *fifo, int fd, size_t len)
+{
+  void *area = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  if (area == MAP_FAILED) {
+    return FIFO__SYSTEM_ERROR;
+  }
+
+  fifo->header = area;
+  fifo->mapped = len;
+
+  return FIFO__OK;
+}
+
+#endif /* __unix__ */
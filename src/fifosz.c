@@ -0,0 +1,14 @@
+#include <fifo.h>
+
+/* fifosz_t
+ *
+ * Fifo with size_t indices. See fifo_impl.h for the implementation.
+ */
+
+#define FIFO_T__NAME                              fifosz
+#define FIFO_T__INDEX                             size_t
+#define FIFO_T__CURSOR                            size_t
+#define FIFO_T__MIRROR                            1
+#define FIFO_T__SIZE_MAX                          FIFOSZ__SIZE_MAX
+
+#include "fifo_impl.h"
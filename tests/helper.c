@@ -58,8 +58,8 @@ void helper__inspect(fifo_t *fifo)
 {
   size_t i;
   size_t size = fifo__size(fifo);
-  uint_fast8_t read  = fifo->read;
-  uint_fast8_t write = fifo->write;
+  uint_fast8_t read  = fifo->read  & (fifo->mask | 0x01);
+  uint_fast8_t write = fifo->write & (fifo->mask | 0x01);
 
   for (i = 0; i < size; i ++) {
     printf("%02X ", fifo->buffer[i]);
@@ -0,0 +1,108 @@
+#include <fifo_coro.hpp>
+
+#include <string>
+
+#define TEST__MESSAGES                              1000
+
+
+static fifo::task test__producer(fifo::async_ring<int, 4> &ring, int count)
+{
+  for (int i = 0; i < count; i ++) {
+    co_await ring.writable();
+    assert(ring.push(i));
+  }
+}
+
+static fifo::task test__consumer(fifo::async_ring<int, 4> &ring, int count,
+                                 int &received)
+{
+  for (int i = 0; i < count; i ++) {
+    co_await ring.readable();
+    assert(ring.pop() == i);
+    received ++;
+  }
+}
+
+static fifo::task test__batch(fifo::async_ring<std::string, 8> &ring,
+                              std::size_t &seen)
+{
+  co_await ring.readable(3);
+  seen = ring.size();
+}
+
+void test__ping_pong(void)
+{
+  fifo::scheduler          sched;
+  fifo::async_ring<int, 4> ring(sched);
+  int                      received = 0;
+
+  /* The producer runs ahead until the ring is full, then both take turns */
+  sched.spawn(test__producer(ring, TEST__MESSAGES));
+  sched.spawn(test__consumer(ring, TEST__MESSAGES, received));
+
+  sched.run();
+
+  assert(received == TEST__MESSAGES);
+  assert(sched.pending() == 0);
+  assert(ring.empty());
+}
+
+void test__wait_for_count(void)
+{
+  fifo::scheduler                  sched;
+  fifo::async_ring<std::string, 8> ring(sched);
+  std::size_t                      seen = 0;
+
+  sched.spawn(test__batch(ring, seen));
+  sched.run();
+  assert(sched.pending() == 1);
+
+  /* Not resumed before three elements are there */
+  ring.push("one");
+  ring.push("two");
+  assert(sched.run() == 0);
+
+  ring.emplace(5, 'x');
+  assert(sched.run() == 1);
+  assert(seen == 3);
+  assert(sched.pending() == 0);
+}
+
+void test__ready_without_suspending(void)
+{
+  fifo::scheduler          sched;
+  fifo::async_ring<int, 4> ring(sched);
+  int                      received = 0;
+
+  ring.push(0);
+  ring.push(1);
+
+  /* All data is already there, so the consumer finishes in one go */
+  sched.spawn(test__consumer(ring, 2, received));
+  assert(sched.run() == 1);
+  assert(received == 2);
+}
+
+void test__abandoned(void)
+{
+  fifo::scheduler          sched;
+  fifo::async_ring<int, 4> ring(sched);
+  int                      received = 0;
+
+  /* Tasks still waiting are destroyed with the scheduler */
+  sched.spawn(test__consumer(ring, 1, received));
+  sched.run();
+  assert(sched.pending() == 1);
+}
+
+int main(int argc, char *argv[])
+{
+  test__ping_pong();
+  test__wait_for_count();
+  test__ready_without_suspending();
+  test__abandoned();
+
+  puts("fifo coro passed all tests");
+
+  return 0;
+}
@@ -0,0 +1,168 @@
+#include <compiler.h>
+#include <fifo_deque.h>
+#include <pthread.h>
+#include <sched.h>
+
+/* Macros ------------------------------------------------------------------- */
+
+#define TEST__THIEVES                               3
+#define TEST__TASKS                                 200000
+
+#define TEST__TASK(i)                             ((void *) (uintptr_t) (i))
+#define TEST__INDEX(task)                         ((size_t) (uintptr_t) (task))
+
+
+/* Global Variables --------------------------------------------------------- */
+
+static fifo_deque_t      test__deque;
+static _Atomic(uint8_t)  test__taken[TEST__TASKS + 1];
+static _Atomic(size_t)   test__done;
+
+
+/* Function Definitions ----------------------------------------------------- */
+
+void test__owner_and_thief(void)
+{
+  fifo_deque_t deque;
+  void        *task = NULL;
+  size_t       i;
+
+  assert(fifo_deque__ctor(&deque, 1) == FIFO__INVALID_SIZE);
+  assert(fifo_deque__ctor(&deque, 6) == FIFO__OK);
+  assert(fifo_deque__size(&deque) == 4);
+
+  assert(!fifo_deque__pop(&deque, &task));
+  assert(!fifo_deque__steal(&deque, &task));
+
+  for (i = 1; i <= 3; i ++) {
+    assert(fifo_deque__push(&deque, TEST__TASK(i)) == FIFO__OK);
+  }
+
+  /* The owner takes the newest task, thieves the oldest. Each task differs
+     from the one before, so a failed call leaves task at a wrong value. */
+  fifo_deque__pop(&deque, &task);
+  assert(task == TEST__TASK(3));
+  fifo_deque__steal(&deque, &task);
+  assert(task == TEST__TASK(1));
+  assert(fifo_deque__used(&deque) == 1);
+  fifo_deque__pop(&deque, &task);
+  assert(task == TEST__TASK(2));
+  assert(!fifo_deque__pop(&deque, &task));
+  assert(fifo_deque__used(&deque) == 0);
+
+  fifo_deque__dtor(&deque);
+}
+
+void test__grow(void)
+{
+  fifo_deque_t deque;
+  void        *task;
+  size_t       i;
+
+  assert(fifo_deque__ctor(&deque, 4) == FIFO__OK);
+
+  /* Move the cursors so that the tasks wrap around the edge when growing */
+  for (i = 0; i < 3; i ++) {
+    fifo_deque__push(&deque, TEST__TASK(0));
+    fifo_deque__steal(&deque, &task);
+  }
+
+  for (i = 1; i <= 20; i ++) {
+    assert(fifo_deque__push(&deque, TEST__TASK(i)) == FIFO__OK);
+  }
+
+  assert(fifo_deque__size(&deque) == 32);
+  assert(fifo_deque__used(&deque) == 20);
+
+  for (i = 1; i <= 10; i ++) {
+    assert(fifo_deque__steal(&deque, &task) && task == TEST__TASK(i));
+  }
+
+  for (i = 20; i > 10; i --) {
+    assert(fifo_deque__pop(&deque, &task) && task == TEST__TASK(i));
+  }
+
+  assert(!fifo_deque__steal(&deque, &task));
+
+  fifo_deque__dtor(&deque);
+}
+
+static void test__take(void *task)
+{
+  size_t const index = TEST__INDEX(task);
+
+  assert(index >= 1 && index <= TEST__TASKS);
+
+  /* A task taken twice is found by the check at the end of the test */
+  atomic_fetch_add(&test__taken[index], 1);
+  atomic_fetch_add(&test__done, 1);
+}
+
+static void *test__thief(void *arg)
+{
+  void *task;
+
+  while (atomic_load(&test__done) < TEST__TASKS) {
+    if (fifo_deque__steal(&test__deque, &task)) {
+      test__take(task);
+    } else {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+void test__concurrent(void)
+{
+  pthread_t thieves[TEST__THIEVES];
+  void     *task;
+  size_t    i;
+
+  assert(fifo_deque__ctor(&test__deque, 2) == FIFO__OK);
+
+  for (i = 0; i < TEST__THIEVES; i ++) {
+    pthread_create(&thieves[i], NULL, test__thief, NULL);
+  }
+
+  /* Push in bursts that make the ring grow, and pop every third task back */
+  for (i = 1; i <= TEST__TASKS; i ++) {
+    assert(fifo_deque__push(&test__deque, TEST__TASK(i)) == FIFO__OK);
+
+    if (i % 3 == 0 && fifo_deque__pop(&test__deque, &task)) {
+      test__take(task);
+    }
+
+    if (i % 1000 == 0) {
+      sched_yield();
+    }
+  }
+
+  while (fifo_deque__pop(&test__deque, &task)) {
+    test__take(task);
+  }
+
+  for (i = 0; i < TEST__THIEVES; i ++) {
+    pthread_join(thieves[i], NULL);
+  }
+
+  /* Every task was taken exactly once */
+  assert(atomic_load(&test__done) == TEST__TASKS);
+
+  for (i = 1; i <= TEST__TASKS; i ++) {
+    assert(atomic_load(&test__taken[i]) == 1);
+  }
+
+  fifo_deque__dtor(&test__deque);
+}
+
+int main(int argc, char *argv[])
+{
+  test__owner_and_thief();
+  test__grow();
+  test__concurrent();
+
+  puts("fifo deque passed all tests");
+
+  return 0;
+}
@@ -222,6 +222,294 @@ void test__uneven_buffer_size(void)
   assert(fifo__size(&fifo) == 8);
 }
 
+void test__wrap_around(void)
+{
+  fifo_t  fifo;
+  uint8_t buffer[16];
+  uint8_t write[16];
+  uint8_t read[16];
+  uint8_t next_write = 0;
+  uint8_t next_read  = 0;
+  size_t  i;
+  size_t  n;
+  size_t  ret;
+
+  fifo__ctor(&fifo, buffer, sizeof(buffer));
+
+  /* Write and read chunks of varying size so that every
+     offset into the buffer is crossed. */
+  for (n = 1; n < 200; n ++) {
+    for (i = 0; i < sizeof(write); i ++) {
+      write[i] = next_write + i;
+    }
+
+    ret = fifo__write(&fifo, write, n % 16 + 1);
+    assert(ret == n % 16 + 1 || fifo__is_full(&fifo));
+    next_write += ret;
+
+    ret = fifo__read(&fifo, read, n % 13 + 1);
+    for (i = 0; i < ret; i ++) {
+      assert(read[i] == next_read++);
+    }
+
+    assert(fifo__used(&fifo) == (uint8_t) (next_write - next_read));
+  }
+}
+
+void test__reserve_commit(void)
+{
+  fifo_t *fifo = helper__setup_fifo();
+  fifo__region_t regions[2];
+  uint8_t write[] = { 1, 2, 3, 4, 5 };
+  uint8_t read[HELPER__BUFFER_SIZE];
+  size_t  ret;
+
+  /* [. . . . . . . .] */
+  ret = fifo__write_reserve(fifo, regions);
+  assert(ret == HELPER__BUFFER_SIZE);
+  assert(regions[0].data == fifo->buffer);
+  assert(regions[0].len == HELPER__BUFFER_SIZE);
+  assert(regions[1].len == 0);
+
+  memcpy(regions[0].data, write, 3);
+  fifo__write_commit(fifo, 3);
+  assert(fifo__used(fifo) == 3);
+
+  /* [. . . . . . 1 2] -> [3 4 5 . . . 1 2] */
+  fifo__read(fifo, read, 3);
+  fifo__write(fifo, write, 3);
+  fifo__read(fifo, read, 3);
+
+  ret = fifo__write_reserve(fifo, regions);
+  assert(ret == HELPER__BUFFER_SIZE);
+  assert(regions[0].data == &fifo->buffer[6]);
+  assert(regions[0].len == 2);
+  assert(regions[1].data == fifo->buffer);
+  assert(regions[1].len == 6);
+
+  memcpy(regions[0].data, write, 2);
+  memcpy(regions[1].data, write + 2, 3);
+  fifo__write_commit(fifo, 5);
+
+  assert(helper__contains(fifo, write, 5));
+
+  /* Committing all of the space fills the fifo */
+  ret = fifo__write_reserve(fifo, regions);
+  fifo__write_commit(fifo, ret);
+  assert(fifo__is_full(fifo));
+  assert(fifo__write_reserve(fifo, regions) == 0);
+}
+
+void test__peek_consume(void)
+{
+  fifo_t *fifo = helper__setup_fifo();
+  fifo__region_t regions[2];
+  uint8_t write[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+  uint8_t read[HELPER__BUFFER_SIZE];
+  size_t  ret;
+
+  assert(fifo__read_peek(fifo, regions) == 0);
+
+  /* [4 5 6 . . 1 2 3] */
+  fifo__write(fifo, write, 5);
+  fifo__read(fifo, read, 5);
+  fifo__write(fifo, write, 6);
+
+  ret = fifo__read_peek(fifo, regions);
+  assert(ret == 6);
+  assert(regions[0].len == 3);
+  assert(regions[1].len == 3);
+  assert(helper__is_equal(regions[0].data, write, 3));
+  assert(helper__is_equal(regions[1].data, write + 3, 3));
+
+  /* Peeking does not remove anything */
+  assert(fifo__used(fifo) == 6);
+
+  fifo__read_consume(fifo, 4);
+  assert(fifo__used(fifo) == 2);
+  assert(helper__contains(fifo, write + 4, 2));
+
+  /* Consuming from a full fifo clears the full state */
+  fifo__write(fifo, write, sizeof(write));
+  assert(fifo__is_full(fifo));
+  fifo__read_consume(fifo, 1);
+  assert(!fifo__is_full(fifo));
+  assert(fifo__available(fifo) == 1);
+}
+
+void test__write_force(void)
+{
+  fifo_t *fifo = helper__setup_fifo();
+  uint8_t write[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+  uint8_t read[HELPER__BUFFER_SIZE];
+
+  /* Nothing is discarded while there is room */
+  assert(fifo__write_force(fifo, write, 5) == 0);
+  assert(fifo__used(fifo) == 5);
+
+  /* [1 2 3 4 5 . . .] -> [9 2 3 4 5 6 7 8] */
+  assert(fifo__write_force(fifo, write + 5, 4) == 1);
+  assert(fifo__is_full(fifo));
+  assert(helper__contains(fifo, write + 1, 8));
+
+  /* Writing more than fits keeps the last bytes */
+  fifo__write(fifo, write, 3);
+  assert(fifo__write_force(fifo, write, sizeof(write)) == 3 + 2);
+  assert(fifo__is_full(fifo));
+  assert(helper__contains(fifo, write + 2, 8));
+
+  /* A full fifo evicts exactly len bytes */
+  fifo__write(fifo, write, 8);
+  assert(fifo__write_force(fifo, write + 8, 2) == 2);
+  fifo__read(fifo, read, 2);
+  assert(read[0] == 3 && read[1] == 4);
+}
+
+void test__messages(void)
+{
+  fifo_t *fifo = helper__setup_fifo();
+  uint8_t write[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+  uint8_t read[HELPER__BUFFER_SIZE];
+  size_t  len;
+
+  assert(fifo__next_msg_len(fifo, &len) == FIFO__EMPTY);
+  assert(fifo__pop_msg(fifo, read, sizeof(read), &len) == FIFO__EMPTY);
+
+  /* [3 1 2 3 0 . . .] */
+  assert(fifo__push_msg(fifo, write, 3) == FIFO__OK);
+  assert(fifo__push_msg(fifo, write, 0) == FIFO__OK);
+  assert(fifo__used(fifo) == 5);
+
+  /* Messages are never split */
+  assert(fifo__push_msg(fifo, write, 3) == FIFO__FULL);
+  assert(fifo__used(fifo) == 5);
+
+  /* A message and its header must fit the fifo */
+  assert(fifo__push_msg(fifo, write, 8) == FIFO__INVALID_SIZE);
+
+  assert(fifo__next_msg_len(fifo, &len) == FIFO__OK);
+  assert(len == 3);
+
+  /* A too small destination leaves the message in the fifo */
+  assert(fifo__pop_msg(fifo, read, 2, &len) == FIFO__INVALID_SIZE);
+  assert(len == 3);
+  assert(fifo__used(fifo) == 5);
+
+  assert(fifo__pop_msg(fifo, read, sizeof(read), &len) == FIFO__OK);
+  assert(len == 3);
+  assert(helper__is_equal(read, write, 3));
+
+  assert(fifo__pop_msg(fifo, read, sizeof(read), &len) == FIFO__OK);
+  assert(len == 0);
+  assert(fifo__is_empty(fifo));
+
+  /* [4 5 6 . . 3 1 2] wraps around the edge */
+  assert(fifo__push_msg(fifo, write, 6) == FIFO__OK);
+  assert(fifo__pop_msg(fifo, read, sizeof(read), &len) == FIFO__OK);
+  assert(len == 6);
+  assert(helper__is_equal(read, write, 6));
+  assert(fifo__is_empty(fifo));
+}
+
+void test__long_messages(void)
+{
+  fifo_t  fifo;
+  uint8_t buffer[FIFO__SIZE_MAX];
+  uint8_t write[200];
+  uint8_t read[200];
+  size_t  len;
+  size_t  i;
+
+  for (i = 0; i < sizeof(write); i ++) {
+    write[i] = i;
+  }
+
+  fifo__ctor(&fifo, buffer, sizeof(buffer));
+
+  /* Lengths from 128 on need a second header byte */
+  assert(fifo__push_msg(&fifo, write, 200) == FIFO__OK);
+  assert(fifo__used(&fifo) == 202);
+  assert(fifo__push_msg(&fifo, write, 127) == FIFO__FULL);
+  assert(fifo__push_msg(&fifo, write, 52) == FIFO__OK);
+  assert(fifo__available(&fifo) == 1);
+
+  assert(fifo__pop_msg(&fifo, read, sizeof(read), &len) == FIFO__OK);
+  assert(len == 200);
+  assert(helper__is_equal(read, write, 200));
+
+  assert(fifo__pop_msg(&fifo, read, sizeof(read), &len) == FIFO__OK);
+  assert(len == 52);
+
+  /* The header of this one starts at the last byte of the buffer */
+  assert(fifo__push_msg(&fifo, write, 150) == FIFO__OK);
+  assert(fifo__next_msg_len(&fifo, &len) == FIFO__OK);
+  assert(len == 150);
+  assert(fifo__pop_msg(&fifo, read, sizeof(read), &len) == FIFO__OK);
+  assert(helper__is_equal(read, write, 150));
+  assert(fifo__is_empty(&fifo));
+}
+
+void test__find(void)
+{
+  fifo_t *fifo = helper__setup_fifo();
+  uint8_t write[] = { 'a', '\n', 'b', 'c', '\n', 'd' };
+  uint8_t read[HELPER__BUFFER_SIZE];
+  size_t  offset;
+  size_t  len;
+
+  assert(fifo__find(fifo, '\n', &offset) == FIFO__EMPTY);
+  assert(fifo__read_until(fifo, read, sizeof(read), '\n', &len) ==
+         FIFO__EMPTY);
+
+  /* [. . . . . a \n b] -> [c \n d . . a \n b] */
+  fifo__write(fifo, write, 5);
+  fifo__read(fifo, read, 5);
+  fifo__write(fifo, write, sizeof(write));
+
+  /* Finding does not consume */
+  assert(fifo__find(fifo, '\n', &offset) == FIFO__OK);
+  assert(offset == 1);
+  assert(fifo__find(fifo, 'd', &offset) == FIFO__OK);
+  assert(offset == 5);
+  assert(fifo__find(fifo, 'x', &offset) == FIFO__EMPTY);
+  assert(fifo__used(fifo) == sizeof(write));
+
+  assert(fifo__read_until(fifo, read, sizeof(read), '\n', &len) == FIFO__OK);
+  assert(len == 2);
+  assert(helper__is_equal(read, write, 2));
+
+  /* The second line starts before the edge and ends after it */
+  assert(fifo__read_until(fifo, read, 2, '\n', &len) == FIFO__INVALID_SIZE);
+  assert(len == 3);
+  assert(fifo__used(fifo) == 4);
+
+  assert(fifo__read_until(fifo, read, sizeof(read), '\n', &len) == FIFO__OK);
+  assert(len == 3);
+  assert(helper__is_equal(read, write + 2, 3));
+
+  /* An incomplete line stays in the fifo */
+  assert(fifo__read_until(fifo, read, sizeof(read), '\n', &len) ==
+         FIFO__EMPTY);
+  assert(fifo__used(fifo) == 1);
+
+  /* A full fifo without the delimiter can never complete the line */
+  fifo__write(fifo, write + 2, 2);
+  fifo__write(fifo, write + 2, 2);
+  fifo__write(fifo, write + 2, 2);
+  assert(fifo__write(fifo, write, 1) == 1);
+  assert(fifo__is_full(fifo));
+
+  assert(fifo__find(fifo, '\n', &offset) == FIFO__FULL);
+  assert(fifo__read_until(fifo, read, sizeof(read), '\n', &len) ==
+         FIFO__FULL);
+  assert(fifo__used(fifo) == HELPER__BUFFER_SIZE);
+
+  /* Draining it makes room again */
+  assert(fifo__read(fifo, read, 1) == 1);
+  assert(fifo__read_until(fifo, read, sizeof(read), '\n', &len) ==
+         FIFO__EMPTY);
+}
+
 int main(int argc, char *argv[])
 {
   test__create();
@@ -232,6 +520,13 @@ int main(int argc, char *argv[])
   test__zero_size_fifo();
   test__resize_zero_size_fifo();
   test__uneven_buffer_size();
+  test__wrap_around();
+  test__reserve_commit();
+  test__peek_consume();
+  test__write_force();
+  test__messages();
+  test__long_messages();
+  test__find();
   
   puts("fifo passed all tests");
   
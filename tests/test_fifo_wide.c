@@ -0,0 +1,172 @@
+#include <compiler.h>
+#include <fifo.h>
+
+#include "helper.h"
+
+#define TEST__WIDE_SIZE                             4096
+
+static uint8_t test__buffer[TEST__WIDE_SIZE * 2];
+static uint8_t test__data[TEST__WIDE_SIZE];
+
+
+static void test__setup_data(void)
+{
+  size_t i;
+
+  for (i = 0; i < sizeof(test__data); i ++) {
+    test__data[i] = (uint8_t) (i * 7 + 3);
+  }
+}
+
+void test__fifo16(void)
+{
+  fifo16_t fifo;
+  uint8_t  read[TEST__WIDE_SIZE];
+  size_t   ret;
+
+  fifo16__ctor(&fifo, test__buffer, TEST__WIDE_SIZE);
+
+  assert(fifo16__size(&fifo) == TEST__WIDE_SIZE);
+  assert(fifo16__is_empty(&fifo));
+
+  /* Fill the fifo past the 8 bit limit */
+  ret = fifo16__write(&fifo, test__data, 1000);
+  assert(ret == 1000);
+  assert(fifo16__used(&fifo) == 1000);
+  assert(fifo16__available(&fifo) == TEST__WIDE_SIZE - 1000);
+
+  ret = fifo16__write(&fifo, test__data, TEST__WIDE_SIZE);
+  assert(ret == TEST__WIDE_SIZE - 1000);
+  assert(fifo16__is_full(&fifo));
+  assert(fifo16__used(&fifo) == TEST__WIDE_SIZE);
+
+  ret = fifo16__read(&fifo, read, 1000);
+  assert(ret == 1000);
+  assert(helper__is_equal(read, test__data, 1000));
+
+  /* Wrap around the edge */
+  ret = fifo16__write(&fifo, test__data, 500);
+  assert(ret == 500);
+
+  ret = fifo16__read(&fifo, read, sizeof(read));
+  assert(ret == TEST__WIDE_SIZE - 500);
+  assert(helper__is_equal(read, test__data, TEST__WIDE_SIZE - 1000));
+  assert(helper__is_equal(read + TEST__WIDE_SIZE - 1000, test__data, 500));
+  assert(fifo16__is_empty(&fifo));
+}
+
+void test__fifo32_resize(void)
+{
+  fifo32_t fifo;
+  uint8_t  read[TEST__WIDE_SIZE * 2];
+  size_t   ret;
+
+  fifo32__ctor(&fifo, test__buffer, TEST__WIDE_SIZE);
+
+  /* Place the content across the edge of the buffer */
+  fifo32__write(&fifo, test__data, 3000);
+  fifo32__read(&fifo, read, 3000);
+  fifo32__write(&fifo, test__data, 2000);
+
+  assert(fifo32__resize(&fifo, TEST__WIDE_SIZE * 2) == FIFO__OK);
+  assert(fifo32__size(&fifo) == TEST__WIDE_SIZE * 2);
+  assert(fifo32__used(&fifo) == 2000);
+
+  ret = fifo32__read(&fifo, read, sizeof(read));
+  assert(ret == 2000);
+  assert(helper__is_equal(read, test__data, 2000));
+
+  /* Shrink with the content in the upper half */
+  fifo32__write(&fifo, test__data, TEST__WIDE_SIZE);
+  fifo32__read(&fifo, read, TEST__WIDE_SIZE);
+  fifo32__write(&fifo, test__data, 1000);
+
+  assert(fifo32__resize(&fifo, 1024) == FIFO__OK);
+  assert(fifo32__size(&fifo) == 1024);
+
+  ret = fifo32__read(&fifo, read, sizeof(read));
+  assert(ret == 1000);
+  assert(helper__is_equal(read, test__data, 1000));
+}
+
+void test__fifosz(void)
+{
+  fifosz_t fifo;
+  uint8_t  read[TEST__WIDE_SIZE];
+
+  fifosz__ctor(&fifo, test__buffer, sizeof(test__buffer) - 1);
+  assert(fifosz__size(&fifo) == TEST__WIDE_SIZE);
+
+  assert(fifosz__write(&fifo, test__data, TEST__WIDE_SIZE)
+            == TEST__WIDE_SIZE);
+  assert(fifosz__is_full(&fifo));
+  assert(fifosz__resize(&fifo, 16) == FIFO__FULL);
+
+  assert(fifosz__read(&fifo, read, sizeof(read)) == TEST__WIDE_SIZE);
+  assert(helper__is_equal(read, test__data, TEST__WIDE_SIZE));
+  assert(fifosz__is_empty(&fifo));
+}
+
+void test__crc(void)
+{
+  fifo32_t fifo;
+  uint8_t  read[TEST__WIDE_SIZE];
+  uint32_t write_crc = 0;
+  uint32_t read_crc  = 0;
+
+  /* Check value of the CRC32C */
+  assert(fifo__crc32c(0, "123456789", 9) == 0xE3069283);
+  assert(fifo__crc32c(fifo__crc32c(0, "1234", 4), "56789", 5) == 0xE3069283);
+
+  /* iSCSI test vectors, 8 bytes at a time */
+  {
+    uint8_t vector[32];
+    size_t  i;
+
+    memset(vector, 0x00, sizeof(vector));
+    assert(fifo__crc32c(0, vector, sizeof(vector)) == 0x8A9136AA);
+    memset(vector, 0xFF, sizeof(vector));
+    assert(fifo__crc32c(0, vector, sizeof(vector)) == 0x62A8AB43);
+
+    for (i = 0; i < sizeof(vector); i ++) {
+      vector[i] = (uint8_t) i;
+    }
+
+    assert(fifo__crc32c(0, vector, sizeof(vector)) == 0x46DD794E);
+  }
+
+  fifo32__ctor(&fifo, test__buffer, TEST__WIDE_SIZE);
+  fifo32__write(&fifo, test__data, 3001);
+  fifo32__read(&fifo, read, 3001);
+
+  /* Both copies run across the edge of the buffer, at an odd offset */
+  assert(fifo32__write_crc(&fifo, test__data, 2000, &write_crc) == 2000);
+  assert(write_crc == fifo__crc32c(0, test__data, 2000));
+
+  assert(fifo32__read_crc(&fifo, read, 1500, &read_crc) == 1500);
+  assert(fifo32__read_crc(&fifo, read + 1500, sizeof(read), &read_crc) ==
+         500);
+  assert(read_crc == write_crc);
+  assert(helper__is_equal(read, test__data, 2000));
+
+  /* Only the bytes that fit are checksummed */
+  write_crc = 0;
+  assert(fifo32__write_crc(&fifo, test__data, sizeof(test__data),
+                           &write_crc) == TEST__WIDE_SIZE);
+  assert(fifo32__write_crc(&fifo, test__data, 1, &write_crc) == 0);
+  assert(write_crc == fifo__crc32c(0, test__data, TEST__WIDE_SIZE));
+}
+
+int main(int argc, char *argv[])
+{
+  test__setup_data();
+
+  test__fifo16();
+  test__fifo32_resize();
+  test__fifosz();
+  test__crc();
+
+  puts("fifo wide passed all tests");
+
+  return 0;
+}
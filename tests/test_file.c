@@ -0,0 +1,268 @@
+#include <compiler.h>
+#include <fifo_file.h>
+
+#include "helper.h"
+
+#ifdef __unix__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define TEST__SIZE                                  4096
+#define TEST__BATCH                                 1024
+
+static char test__path[64];
+
+
+/* Fills data with a pattern that depends on the stream position. */
+static void test__pattern(uint8_t *data, size_t len, size_t position)
+{
+  size_t i;
+
+  for (i = 0; i < len; i ++) {
+    data[i] = (uint8_t) ((position + i) * 13);
+  }
+}
+
+void test__reopen(void)
+{
+  fifo_file_t fifo;
+  uint8_t     write[1000];
+  uint8_t     read[1000];
+  uint8_t     expected[1000];
+
+  test__pattern(write, sizeof(write), 0);
+
+  /* Rounded up to a power of 2 */
+  assert(fifo_file__open(&fifo, test__path, 3000, TEST__BATCH) == FIFO__OK);
+  assert(fifo_file__size(&fifo) == TEST__SIZE);
+  assert(fifo_file__used(&fifo) == 0);
+
+  /* A second handle cannot open the file at the same time */
+  {
+    fifo_file_t other;
+
+    assert(fifo_file__open(&other, test__path, TEST__SIZE, 0) ==
+           FIFO__SYSTEM_ERROR);
+    assert(errno == EWOULDBLOCK);
+  }
+
+  assert(fifo_file__write(&fifo, write, sizeof(write)) == sizeof(write));
+  assert(fifo_file__read(&fifo, read, 100) == 100);
+  assert(fifo_file__close(&fifo) == FIFO__OK);
+  assert(fifo.header == NULL);
+
+  /* The size of an existing fifo is kept, and its contents recovered */
+  assert(fifo_file__open(&fifo, test__path, 64, TEST__BATCH) == FIFO__OK);
+  assert(fifo_file__size(&fifo) == TEST__SIZE);
+  assert(fifo_file__used(&fifo) == 900);
+  assert(fifo_file__read(&fifo, read, sizeof(read)) == 900);
+  test__pattern(expected, 900, 100);
+  assert(helper__is_equal(read, expected, 900));
+
+  /* Wrap around the edge of the buffer */
+  test__pattern(write, sizeof(write), 1000);
+  assert(fifo_file__write(&fifo, write, sizeof(write)) == sizeof(write));
+  assert(fifo_file__write(&fifo, write, sizeof(write)) == sizeof(write));
+  assert(fifo_file__write(&fifo, write, sizeof(write)) == sizeof(write));
+  assert(fifo_file__write(&fifo, write, sizeof(write)) == sizeof(write));
+  assert(fifo_file__write(&fifo, write, sizeof(write)) == 96);
+  assert(fifo_file__available(&fifo) == 0);
+  assert(fifo_file__close(&fifo) == FIFO__OK);
+
+  assert(fifo_file__open(&fifo, test__path, TEST__SIZE, 0) == FIFO__OK);
+  assert(fifo_file__used(&fifo) == TEST__SIZE);
+  assert(fifo_file__read(&fifo, read, sizeof(read)) == sizeof(read));
+  assert(helper__is_equal(read, write, sizeof(write)));
+  assert(fifo_file__close(&fifo) == FIFO__OK);
+
+  assert(unlink(test__path) == 0);
+}
+
+void test__space(void)
+{
+  fifo_file_t fifo;
+  uint8_t     data[TEST__SIZE];
+
+  /* Never commits by itself */
+  assert(fifo_file__open(&fifo, test__path, TEST__SIZE, SIZE_MAX) ==
+         FIFO__OK);
+  assert(fifo_file__write(&fifo, data, sizeof(data)) == sizeof(data));
+  assert(fifo_file__read(&fifo, data, 1000) == 1000);
+  assert(fifo.committed_read == 0);
+
+  /* Reusing the space commits the read that freed it */
+  assert(fifo_file__available(&fifo) == 1000);
+  assert(fifo_file__write(&fifo, data, 2000) == 1000);
+  assert(fifo.committed_read == 1000);
+  assert(fifo.committed_write == TEST__SIZE);
+
+  assert(fifo_file__close(&fifo) == FIFO__OK);
+  assert(unlink(test__path) == 0);
+}
+
+void test__crash(void)
+{
+  fifo_file_t fifo;
+  uint8_t     data[3000];
+  uint8_t     expected[3000];
+  int         status;
+  pid_t       child;
+
+  child = fork();
+  assert(child >= 0);
+
+  if (child == 0) {
+    /* Commit every batch, then end without closing in the middle of one */
+    if (fifo_file__open(&fifo, test__path, TEST__SIZE, TEST__BATCH) !=
+        FIFO__OK) {
+      _exit(1);
+    }
+
+    test__pattern(data, sizeof(data), 0);
+    fifo_file__write(&fifo, data, TEST__BATCH);
+    fifo_file__write(&fifo, data + TEST__BATCH, TEST__BATCH);
+    fifo_file__read(&fifo, data, 100);
+    fifo_file__write(&fifo, data, 500);
+    _exit(0);
+  }
+
+  assert(waitpid(child, &status, 0) == child);
+  assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  /* Only what was committed is recovered */
+  assert(fifo_file__open(&fifo, test__path, TEST__SIZE, TEST__BATCH) ==
+         FIFO__OK);
+  assert(fifo.sequence == 2);
+  assert(fifo_file__used(&fifo) == 2 * TEST__BATCH);
+  assert(fifo_file__read(&fifo, data, sizeof(data)) == 2 * TEST__BATCH);
+  test__pattern(expected, sizeof(expected), 0);
+  assert(helper__is_equal(data, expected, 2 * TEST__BATCH));
+  assert(fifo_file__close(&fifo) == FIFO__OK);
+}
+
+void test__torn_commit(void)
+{
+  fifo_file_t         fifo;
+  fifo_file__header_t header;
+  uint8_t             data[100];
+  int                 fd;
+
+  /* The file of test__crash, with sequence 3 in commit record 1 */
+  fd = open(test__path, O_RDWR);
+  assert(fd >= 0);
+  assert(pread(fd, &header, sizeof(header), 0) == sizeof(header));
+  assert(header.commit[1].sequence == 3);
+  assert(header.commit[0].sequence == 2);
+
+  /* Tear the latest record, the previous one is used instead */
+  header.commit[1].write ++;
+  assert(pwrite(fd, &header, sizeof(header), 0) == sizeof(header));
+
+  assert(fifo_file__open(&fifo, test__path, TEST__SIZE, 0) == FIFO__OK);
+  assert(fifo.sequence == 2);
+  assert(fifo_file__used(&fifo) == 2 * TEST__BATCH);
+  assert(fifo_file__read(&fifo, data, sizeof(data)) == sizeof(data));
+  assert(fifo.sequence == 3);
+  assert(fifo_file__close(&fifo) == FIFO__OK);
+
+  /* Without an intact record the file is rejected */
+  assert(pread(fd, &header, sizeof(header), 0) == sizeof(header));
+  header.commit[0].read ++;
+  header.commit[1].read ++;
+  assert(pwrite(fd, &header, sizeof(header), 0) == sizeof(header));
+  assert(fifo_file__open(&fifo, test__path, TEST__SIZE, 0) ==
+         FIFO__SYSTEM_ERROR);
+  assert(errno == EINVAL);
+
+  /* As are files that do not hold a fifo at all */
+  assert(ftruncate(fd, 0) == 0);
+  assert(pwrite(fd, "Hello", 5, 0) == 5);
+  assert(fifo_file__open(&fifo, test__path, TEST__SIZE, 0) ==
+         FIFO__SYSTEM_ERROR);
+  assert(errno == EINVAL);
+
+  close(fd);
+  assert(unlink(test__path) == 0);
+}
+
+void test__set_up(void)
+{
+  fifo_file_t         fifo;
+  fifo_file__header_t header;
+  uint8_t             data[2 * TEST__SIZE] = { 0 };
+  uint8_t             check[2 * TEST__SIZE];
+  uint32_t const      magic = 0;
+  int                 fd;
+
+  /* A file left by a crash during the set up is set up again, whether it was
+     still at the size of the header or already at its full size */
+  assert(fifo_file__open(&fifo, test__path, TEST__SIZE, 0) == FIFO__OK);
+  assert(fifo_file__close(&fifo) == FIFO__OK);
+
+  fd = open(test__path, O_RDWR);
+  assert(fd >= 0);
+  assert(pwrite(fd, &magic, sizeof(magic), 0) == sizeof(magic));
+  assert(fifo_file__open(&fifo, test__path, TEST__SIZE, 0) == FIFO__OK);
+  assert(fifo_file__close(&fifo) == FIFO__OK);
+
+  assert(pwrite(fd, &magic, sizeof(magic), 0) == sizeof(magic));
+  assert(ftruncate(fd, sizeof(header)) == 0);
+  assert(fifo_file__open(&fifo, test__path, TEST__SIZE, 0) == FIFO__OK);
+  assert(fifo_file__size(&fifo) == TEST__SIZE);
+  assert(fifo_file__used(&fifo) == 0);
+  assert(fifo_file__close(&fifo) == FIFO__OK);
+
+  /* But not if anything else in the header differs */
+  assert(pread(fd, &header, sizeof(header), 0) == sizeof(header));
+  header.magic = 0;
+  header.commit[0].sequence = 1;
+  header.commit[0].checksum = 0;
+  assert(pwrite(fd, &header, sizeof(header), 0) == sizeof(header));
+  assert(fifo_file__open(&fifo, test__path, TEST__SIZE, 0) ==
+         FIFO__SYSTEM_ERROR);
+  assert(errno == EINVAL);
+
+  /* Other files starting with zeros are rejected and left unchanged */
+  test__pattern(data + 64, sizeof(data) - 64, 0);
+  assert(ftruncate(fd, 0) == 0);
+  assert(pwrite(fd, data, sizeof(data), 0) == sizeof(data));
+  assert(fifo_file__open(&fifo, test__path, TEST__SIZE, 0) ==
+         FIFO__SYSTEM_ERROR);
+  assert(errno == EINVAL);
+  assert(pread(fd, check, sizeof(check), 0) == sizeof(check));
+  assert(helper__is_equal(check, data, sizeof(data)));
+  assert(lseek(fd, 0, SEEK_END) == sizeof(data));
+
+  close(fd);
+  assert(unlink(test__path) == 0);
+}
+
+int main(int argc, char *argv[])
+{
+  snprintf(test__path, sizeof(test__path), "/tmp/test_file_%ld.fifo",
+           (long) getpid());
+
+  test__reopen();
+  test__space();
+  test__crash();
+  test__torn_commit();
+  test__set_up();
+
+  puts("fifo file passed all tests");
+
+  return 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+  puts("fifo file skipped, memory mapped files need a Unix like system");
+
+  return 0;
+}
+
+#endif
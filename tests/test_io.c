@@ -0,0 +1,140 @@
+#include <compiler.h>
+#include <fifo.h>
+
+#include "helper.h"
+
+#ifdef __unix__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+
+void test__writev_readv(void)
+{
+  fifo_t *fifo = helper__setup_fifo();
+  uint8_t a[3] = { 1, 2, 3 };
+  uint8_t b[4] = { 4, 5, 6, 7 };
+  uint8_t c[5] = { 8, 9, 10, 11, 12 };
+  uint8_t read_a[2];
+  uint8_t read_b[8];
+  struct iovec write_iov[] = {
+    { a, sizeof(a) }, { b, sizeof(b) }, { c, sizeof(c) }
+  };
+  struct iovec read_iov[] = {
+    { read_a, sizeof(read_a) }, { read_b, sizeof(read_b) }
+  };
+
+  /* Writes stop when the fifo is full, in the middle of c */
+  assert(fifo__writev(fifo, write_iov, 3) == HELPER__BUFFER_SIZE);
+  assert(fifo__is_full(fifo));
+
+  assert(fifo__readv(fifo, read_iov, 2) == HELPER__BUFFER_SIZE);
+  assert(read_a[0] == 1 && read_a[1] == 2);
+  assert(helper__is_equal(read_b, (uint8_t const *) "\3\4\5\6\7\10", 6));
+  assert(fifo__is_empty(fifo));
+
+  /* [11 12 . . . 8 9 10] wraps around the edge */
+  assert(fifo__writev(fifo, &write_iov[2], 1) == sizeof(c));
+  assert(fifo__readv(fifo, &read_iov[1], 1) == sizeof(c));
+  assert(helper__is_equal(read_b, c, sizeof(c)));
+
+  assert(fifo__writev(fifo, write_iov, 0) == 0);
+  assert(fifo__readv(fifo, read_iov, 2) == 0);
+}
+
+void test__pipe(void)
+{
+  fifo_t *fifo = helper__setup_fifo();
+  uint8_t read[16];
+  size_t  len;
+  int     fds[2];
+
+  assert(pipe(fds) == 0);
+  assert(fcntl(fds[0], F_SETFL, O_NONBLOCK) == 0);
+
+  /* Move the edge so that both calls need two regions */
+  fifo__write(fifo, "xxxxx", 5);
+  fifo__read(fifo, read, 5);
+
+  assert(write(fds[1], "abcdefghij", 10) == 10);
+
+  assert(fifo__read_from_fd(fifo, fds[0], &len) == FIFO__OK);
+  assert(len == HELPER__BUFFER_SIZE);
+  assert(fifo__is_full(fifo));
+
+  assert(fifo__read_from_fd(fifo, fds[0], &len) == FIFO__FULL);
+  assert(len == 0);
+
+  /* Send it back, behind the bytes still in the pipe */
+  assert(fifo__write_to_fd(fifo, fds[1], &len) == FIFO__OK);
+  assert(len == HELPER__BUFFER_SIZE);
+  assert(fifo__write_to_fd(fifo, fds[1], &len) == FIFO__EMPTY);
+
+  assert(fifo__read_from_fd(fifo, fds[0], &len) == FIFO__OK);
+  assert(len == HELPER__BUFFER_SIZE);
+  assert(helper__contains(fifo, (uint8_t const *) "ijabcdef", 8));
+
+  assert(fifo__read_from_fd(fifo, fds[0], &len) == FIFO__OK);
+  assert(len == 2);
+  assert(helper__contains(fifo, (uint8_t const *) "gh", 2));
+
+  /* Errors are passed on through errno */
+  assert(fifo__read_from_fd(fifo, fds[0], &len) == FIFO__SYSTEM_ERROR);
+  assert(errno == EAGAIN);
+
+  /* End of file */
+  close(fds[1]);
+  assert(fifo__read_from_fd(fifo, fds[0], &len) == FIFO__OK);
+  assert(len == 0);
+
+  close(fds[0]);
+}
+
+void test__socket(void)
+{
+  fifo_t  fifo;
+  uint8_t buffer[64];
+  uint8_t read[64];
+  size_t  len;
+  int     fds[2];
+
+  assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+  fifo__ctor(&fifo, buffer, sizeof(buffer));
+  fifo__write(&fifo, "Hello World", 11);
+
+  assert(fifo__write_to_fd(&fifo, fds[0], &len) == FIFO__OK);
+  assert(len == 11);
+
+  assert(fifo__read_from_fd(&fifo, fds[1], &len) == FIFO__OK);
+  assert(len == 11);
+  assert(fifo__read(&fifo, read, sizeof(read)) == 11);
+  assert(memcmp(read, "Hello World", 11) == 0);
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+int main(int argc, char *argv[])
+{
+  test__writev_readv();
+  test__pipe();
+  test__socket();
+
+  puts("fifo io passed all tests");
+
+  return 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+  puts("fifo io skipped, file descriptors are not supported");
+
+  return 0;
+}
+
+#endif
@@ -0,0 +1,102 @@
+#include <compiler.h>
+#include <fifo.h>
+#include <fifo_mirror.h>
+
+#include "helper.h"
+
+#ifdef __linux__
+
+void test__mirror(void)
+{
+  fifo_mirror_t mirror;
+
+  assert(fifo_mirror__ctor(&mirror, 1) == FIFO__OK);
+  assert(mirror.size >= 4096);
+  assert((mirror.size & (mirror.size - 1)) == 0);
+
+  /* Writes to the first view show up in the second */
+  mirror.buffer[0] = 0xA5;
+  assert(mirror.buffer[mirror.size] == 0xA5);
+
+  mirror.buffer[mirror.size + 1] = 0x5A;
+  assert(mirror.buffer[1] == 0x5A);
+
+  fifo_mirror__dtor(&mirror);
+  assert(mirror.buffer == NULL);
+
+  /* Sizes that would not fit twice in the address space are rejected */
+  assert(fifo_mirror__ctor(&mirror, FIFO_MIRROR__SIZE_MAX + 1) ==
+         FIFO__INVALID_SIZE);
+  assert(fifo_mirror__ctor(&mirror, SIZE_MAX - 1) == FIFO__INVALID_SIZE);
+}
+
+void test__mirrored_fifo(void)
+{
+  fifo_mirror_t  mirror;
+  fifo32_t       fifo;
+  fifo__region_t regions[2];
+  uint8_t        data[1000];
+  uint8_t        read[1000];
+  size_t         offset;
+  size_t         i;
+
+  for (i = 0; i < sizeof(data); i ++) {
+    data[i] = (uint8_t) (i * 13);
+  }
+
+  assert(fifo_mirror__ctor(&mirror, 4096) == FIFO__OK);
+  fifo32__ctor_mirrored(&fifo, mirror.buffer, mirror.size);
+
+  /* Move the cursors to just before the edge */
+  offset = mirror.size - 300;
+
+  while (offset > 0) {
+    size_t len = offset < sizeof(data) ? offset : sizeof(data);
+
+    fifo32__write(&fifo, data, len);
+    fifo32__read(&fifo, read, len);
+    offset -= len;
+  }
+
+  /* Data that wraps is still handed out as one region */
+  assert(fifo32__write(&fifo, data, sizeof(data)) == sizeof(data));
+  assert(fifo32__read_peek(&fifo, regions) == sizeof(data));
+  assert(regions[0].len == sizeof(data));
+  assert(regions[1].len == 0);
+  assert(helper__is_equal(regions[0].data, data, sizeof(data)));
+
+  assert(fifo32__read(&fifo, read, sizeof(read)) == sizeof(data));
+  assert(helper__is_equal(read, data, sizeof(data)));
+
+  /* So is the free space */
+  assert(fifo32__write_reserve(&fifo, regions) == mirror.size);
+  assert(regions[1].len == 0);
+
+  /* The mirror cannot follow a resize */
+  assert(fifo32__resize(&fifo, mirror.size * 2) == FIFO__INVALID_SIZE);
+  assert(fifo32__resize(&fifo, 0) == FIFO__INVALID_SIZE);
+  assert(fifo32__size(&fifo) == mirror.size);
+
+  fifo_mirror__dtor(&mirror);
+}
+
+int main(int argc, char *argv[])
+{
+  test__mirror();
+  test__mirrored_fifo();
+
+  puts("fifo mirror passed all tests");
+
+  return 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+  puts("fifo mirror skipped, mirrored buffers require Linux");
+
+  return 0;
+}
+
+#endif
@@ -0,0 +1,136 @@
+#include <compiler.h>
+#include <fifo_mpmc.h>
+#include <pthread.h>
+#include <sched.h>
+
+/* Macros ------------------------------------------------------------------- */
+
+#define TEST__SIZE                                  16
+#define TEST__THREADS                               3
+#define TEST__PER_THREAD                            100000
+
+
+/* Data Types --------------------------------------------------------------- */
+
+typedef struct {
+  uint32_t producer;
+  uint32_t value;
+} test__element_t;
+
+
+/* Global Variables --------------------------------------------------------- */
+
+static size_t test__buffer[FIFO_MPMC__BUFFER_SIZE(TEST__SIZE,
+                                                  sizeof(test__element_t))
+                           / sizeof(size_t)];
+static fifo_mpmc_t test__fifo;
+
+static _Atomic(uint64_t) test__sum;
+static _Atomic(size_t)   test__consumed;
+
+
+/* Function Definitions ----------------------------------------------------- */
+
+void test__single_thread(void)
+{
+  fifo_mpmc_t     fifo;
+  test__element_t element;
+  uint32_t        i;
+
+  /* Uneven sizes are rounded down */
+  fifo_mpmc__ctor(&fifo, test__buffer, TEST__SIZE + 3,
+                  sizeof(test__element_t));
+  assert(fifo_mpmc__size(&fifo) == TEST__SIZE);
+  assert(fifo_mpmc__read(&fifo, &element) == 0);
+
+  for (i = 0; i < TEST__SIZE; i ++) {
+    element.value = i;
+    assert(fifo_mpmc__write(&fifo, &element));
+  }
+
+  assert(fifo_mpmc__write(&fifo, &element) == 0);
+  assert(fifo_mpmc__used(&fifo) == TEST__SIZE);
+
+  /* Elements come out in order, across several laps */
+  for (i = 0; i < TEST__SIZE * 3; i ++) {
+    assert(fifo_mpmc__read(&fifo, &element));
+    assert(element.value == i);
+
+    element.value = i + TEST__SIZE;
+    assert(fifo_mpmc__write(&fifo, &element));
+  }
+}
+
+static void *test__producer(void *arg)
+{
+  test__element_t element;
+
+  element.producer = (uint32_t) (uintptr_t) arg;
+
+  for (element.value = 1; element.value <= TEST__PER_THREAD; ) {
+    if (fifo_mpmc__write(&test__fifo, &element)) {
+      element.value ++;
+    } else {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+static void *test__consumer(void *arg)
+{
+  uint32_t        last[TEST__THREADS] = { 0 };
+  test__element_t element;
+
+  while (atomic_load(&test__consumed) < TEST__THREADS * TEST__PER_THREAD) {
+    if (fifo_mpmc__read(&test__fifo, &element)) {
+      /* Each producer's elements arrive in order */
+      assert(element.value > last[element.producer]);
+      last[element.producer] = element.value;
+
+      atomic_fetch_add(&test__sum, element.value);
+      atomic_fetch_add(&test__consumed, 1);
+    } else {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+void test__multiple_threads(void)
+{
+  pthread_t producers[TEST__THREADS];
+  pthread_t consumers[TEST__THREADS];
+  uintptr_t i;
+
+  fifo_mpmc__ctor(&test__fifo, test__buffer, TEST__SIZE,
+                  sizeof(test__element_t));
+
+  for (i = 0; i < TEST__THREADS; i ++) {
+    pthread_create(&consumers[i], NULL, test__consumer, NULL);
+    pthread_create(&producers[i], NULL, test__producer, (void *) i);
+  }
+
+  for (i = 0; i < TEST__THREADS; i ++) {
+    pthread_join(producers[i], NULL);
+    pthread_join(consumers[i], NULL);
+  }
+
+  /* Every element was read exactly once */
+  assert(atomic_load(&test__sum) ==
+         (uint64_t) TEST__THREADS * TEST__PER_THREAD *
+         (TEST__PER_THREAD + 1) / 2);
+  assert(fifo_mpmc__used(&test__fifo) == 0);
+}
+
+int main(int argc, char *argv[])
+{
+  test__single_thread();
+  test__multiple_threads();
+
+  puts("fifo mpmc passed all tests");
+
+  return 0;
+}
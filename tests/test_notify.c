@@ -0,0 +1,211 @@
+#include <compiler.h>
+#include <fifo.h>
+#include <poll.h>
+#include <pthread.h>
+
+#include "helper.h"
+
+/* These tests only run when the library is built with notifications, e.g.
+ * make test CC="gcc -DFIFO__SPSC -DFIFO__NOTIFY"
+ */
+
+#define TEST__TRANSFER_SIZE                         (256 * 1024)
+
+#ifdef FIFO__NOTIFY
+
+#include <sys/eventfd.h>
+
+static uint8_t test__buffer[64];
+
+
+/* Wait for fd to become readable and clear it. Returns 0 on timeout. */
+static bool_t test__wait(int fd, int timeout_ms)
+{
+  struct pollfd pfd = { .fd = fd, .events = POLLIN };
+  eventfd_t     value;
+
+  if (poll(&pfd, 1, timeout_ms) != 1) {
+    return 0;
+  }
+
+  assert(eventfd_read(fd, &value) == 0);
+
+  return 1;
+}
+
+static void *test__producer(void *arg)
+{
+  fifo_t  *fifo = (fifo_t *) arg;
+  uint8_t  chunk[29];
+  uint8_t  next = 0;
+  size_t   sent = 0;
+  size_t   len  = 1;
+  size_t   i;
+
+  while (sent < TEST__TRANSFER_SIZE) {
+    size_t ret;
+
+    if (len > TEST__TRANSFER_SIZE - sent) {
+      len = TEST__TRANSFER_SIZE - sent;
+    }
+
+    for (i = 0; i < len; i ++) {
+      chunk[i] = next + i;
+    }
+
+    ret = fifo__write(fifo, chunk, len);
+
+    /* Sleep until the consumer frees up space */
+    if (ret < len) {
+      test__wait(fifo__space_fd(fifo), -1);
+    }
+
+    next += ret;
+    sent += ret;
+    len   = len % sizeof(chunk) + 1;
+  }
+
+  return NULL;
+}
+
+void test__coalesced_data(void)
+{
+  fifo_t    fifo;
+  uint8_t   read[16];
+  eventfd_t value;
+
+  fifo__ctor(&fifo, test__buffer, 16);
+  assert(fifo__notify_ctor(&fifo, 1) == FIFO__OK);
+  assert(fifo__space_fd(&fifo) >= 0);
+
+  assert(!test__wait(fifo__data_fd(&fifo), 0));
+
+  /* A burst of writes signals once */
+  fifo__write(&fifo, "abc", 3);
+  fifo__write(&fifo, "def", 3);
+  fifo__write(&fifo, "ghi", 3);
+
+  assert(eventfd_read(fifo__data_fd(&fifo), &value) == 0);
+  assert(value == 1);
+
+  /* Nothing more until the consumer runs dry */
+  fifo__read(&fifo, read, 4);
+  fifo__write(&fifo, "jk", 2);
+  assert(!test__wait(fifo__data_fd(&fifo), 0));
+
+  assert(fifo__read(&fifo, read, sizeof(read)) == 7);
+  assert(fifo__read(&fifo, read, sizeof(read)) == 0);
+  assert(!test__wait(fifo__data_fd(&fifo), 0));
+
+  fifo__write(&fifo, "l", 1);
+  assert(test__wait(fifo__data_fd(&fifo), 0));
+
+  fifo__notify_dtor(&fifo);
+  assert(fifo__data_fd(&fifo) == -1);
+}
+
+void test__space_threshold(void)
+{
+  fifo_t  fifo;
+  uint8_t read[16];
+
+  fifo__ctor(&fifo, test__buffer, 8);
+  assert(fifo__notify_ctor(&fifo, 4) == FIFO__OK);
+
+  assert(fifo__write(&fifo, "abcdefgh", 8) == 8);
+  assert(fifo__write(&fifo, "i", 1) == 0);
+  assert(!test__wait(fifo__space_fd(&fifo), 0));
+
+  /* Not signalled until 4 bytes are free */
+  fifo__read(&fifo, read, 3);
+  assert(!test__wait(fifo__space_fd(&fifo), 0));
+
+  fifo__read(&fifo, read, 1);
+  assert(test__wait(fifo__space_fd(&fifo), 0));
+
+  /* A short write signals at once while the threshold is free */
+  assert(fifo__write(&fifo, "ijklm", 5) == 4);
+  assert(test__wait(fifo__space_fd(&fifo), 0));
+
+  /* Flushing frees space too */
+  assert(fifo__write(&fifo, "m", 1) == 0);
+  assert(!test__wait(fifo__space_fd(&fifo), 0));
+  fifo__flush(&fifo);
+  assert(test__wait(fifo__space_fd(&fifo), 0));
+
+  fifo__notify_dtor(&fifo);
+}
+
+void test__data_before_ctor(void)
+{
+  fifo_t fifo;
+
+  fifo__ctor(&fifo, test__buffer, 8);
+  fifo__write(&fifo, "abc", 3);
+
+  assert(fifo__notify_ctor(&fifo, 1) == FIFO__OK);
+  assert(test__wait(fifo__data_fd(&fifo), 0));
+
+  fifo__notify_dtor(&fifo);
+}
+
+void test__event_loop_transfer(void)
+{
+  fifo_t    fifo;
+  pthread_t producer;
+  uint8_t   chunk[31];
+  uint8_t   next     = 0;
+  size_t    received = 0;
+  size_t    i;
+
+  fifo__ctor(&fifo, test__buffer, sizeof(test__buffer));
+  assert(fifo__notify_ctor(&fifo, sizeof(test__buffer) / 2) == FIFO__OK);
+
+  pthread_create(&producer, NULL, test__producer, &fifo);
+
+  while (received < TEST__TRANSFER_SIZE) {
+    size_t ret;
+
+    /* Drain the fifo, then sleep until the producer signals */
+    while ((ret = fifo__read(&fifo, chunk, sizeof(chunk))) > 0) {
+      for (i = 0; i < ret; i ++) {
+        assert(chunk[i] == next);
+        next ++;
+      }
+
+      received += ret;
+    }
+
+    if (received < TEST__TRANSFER_SIZE) {
+      test__wait(fifo__data_fd(&fifo), -1);
+    }
+  }
+
+  pthread_join(producer, NULL);
+
+  assert(fifo__is_empty(&fifo));
+  fifo__notify_dtor(&fifo);
+}
+
+int main(int argc, char *argv[])
+{
+  test__coalesced_data();
+  test__space_threshold();
+  test__data_before_ctor();
+  test__event_loop_transfer();
+
+  puts("fifo notify passed all tests");
+
+  return 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+  puts("fifo notify skipped, the library is not built with FIFO__NOTIFY");
+
+  return 0;
+}
+
+#endif
@@ -0,0 +1,171 @@
+#include <compiler.h>
+#include <fifo_prio.h>
+
+/* Macros ------------------------------------------------------------------- */
+
+#define TEST__LANE_SIZE                             64
+
+
+/* Global Variables --------------------------------------------------------- */
+
+static uint8_t test__buffers[FIFO_PRIO__LANES_MAX][TEST__LANE_SIZE];
+
+
+/* Function Definitions ----------------------------------------------------- */
+
+static void test__lanes(fifo_prio_t *prio, fifo_prio__policy_t policy,
+                        uint32_t const *weights, size_t lanes)
+{
+  size_t i;
+
+  fifo_prio__ctor(prio, policy);
+
+  for (i = 0; i < lanes; i ++) {
+    assert(fifo_prio__lane_ctor(prio, i, test__buffers[i], TEST__LANE_SIZE,
+                                weights[i]) == FIFO__OK);
+  }
+}
+
+/* Pops a message and returns the lane it came from. The message is expected
+ * to be a single byte holding the lane number.
+ */
+static size_t test__pop(fifo_prio_t *prio)
+{
+  uint8_t dest;
+  size_t  len;
+  size_t  lane;
+
+  assert(fifo_prio__pop(prio, &dest, sizeof(dest), &len, &lane) == FIFO__OK);
+  assert(len == 1 && dest == lane);
+
+  return lane;
+}
+
+static void test__push(fifo_prio_t *prio, size_t lane, size_t count)
+{
+  uint8_t const src = lane;
+
+  while (count -- > 0) {
+    assert(fifo_prio__push(prio, lane, &src, 1) == FIFO__OK);
+  }
+}
+
+void test__ctor(void)
+{
+  fifo_prio_t prio;
+  uint8_t     dest[8];
+  size_t      len;
+  size_t      lane;
+
+  fifo_prio__ctor(&prio, FIFO_PRIO__STRICT);
+  assert(fifo_prio__is_empty(&prio));
+  assert(fifo_prio__pop(&prio, dest, sizeof(dest), &len, &lane) ==
+         FIFO__EMPTY);
+
+  assert(fifo_prio__lane_ctor(&prio, FIFO_PRIO__LANES_MAX, test__buffers[0],
+                              TEST__LANE_SIZE, 1) == FIFO__INVALID_SIZE);
+  assert(fifo_prio__lane_ctor(&prio, 0, test__buffers[0], 2, 1) ==
+         FIFO__INVALID_SIZE);
+  assert(fifo_prio__lane_ctor(&prio, 0, test__buffers[0],
+                              (size_t) FIFO32__SIZE_MAX + 1, 1) ==
+         FIFO__INVALID_SIZE);
+  assert(fifo_prio__lane_ctor(&prio, 0, test__buffers[0], TEST__LANE_SIZE,
+                              0) == FIFO__INVALID_SIZE);
+  assert(fifo_prio__lane_ctor(&prio, FIFO_PRIO__LANES_MAX - 1,
+                              test__buffers[0], TEST__LANE_SIZE, 1) ==
+         FIFO__OK);
+
+  /* Too large messages stay in their lane */
+  assert(fifo_prio__push(&prio, FIFO_PRIO__LANES_MAX - 1, "message", 8) ==
+         FIFO__OK);
+  assert(!fifo_prio__is_empty(&prio));
+  assert(fifo_prio__pop(&prio, dest, 4, &len, &lane) == FIFO__INVALID_SIZE);
+  assert(len == 8 && lane == FIFO_PRIO__LANES_MAX - 1);
+  assert(fifo_prio__pop(&prio, dest, sizeof(dest), &len, &lane) == FIFO__OK);
+  assert(len == 8 && memcmp(dest, "message", 8) == 0);
+  assert(fifo_prio__is_empty(&prio));
+
+  /* Full lanes do not affect the others */
+  while (fifo_prio__push(&prio, FIFO_PRIO__LANES_MAX - 1, dest, 8) ==
+         FIFO__OK) {
+  }
+
+  assert(fifo_prio__push(&prio, FIFO_PRIO__LANES_MAX - 1, dest, 8) ==
+         FIFO__FULL);
+  assert(fifo_prio__lane_ctor(&prio, 0, test__buffers[1], TEST__LANE_SIZE,
+                              1) == FIFO__OK);
+  assert(fifo_prio__push(&prio, 0, dest, 8) == FIFO__OK);
+  assert(fifo_prio__pop(&prio, dest, sizeof(dest), &len, &lane) == FIFO__OK);
+  assert(lane == 0);
+}
+
+void test__strict(void)
+{
+  static uint32_t const weights[] = { 1, 1, 1 };
+  fifo_prio_t prio;
+
+  test__lanes(&prio, FIFO_PRIO__STRICT, weights, 3);
+
+  test__push(&prio, 2, 3);
+  test__push(&prio, 1, 2);
+  test__push(&prio, 0, 1);
+
+  assert(test__pop(&prio) == 0);
+  assert(test__pop(&prio) == 1);
+
+  /* A new message on a higher lane overtakes those already waiting */
+  test__push(&prio, 0, 1);
+  assert(test__pop(&prio) == 0);
+  assert(test__pop(&prio) == 1);
+  assert(test__pop(&prio) == 2);
+  assert(test__pop(&prio) == 2);
+  assert(test__pop(&prio) == 2);
+  assert(fifo_prio__is_empty(&prio));
+}
+
+void test__weighted(void)
+{
+  static uint32_t const weights[] = { 3, 1, 2 };
+  static size_t const   order[] = { 0, 0, 0, 1, 2, 2,
+                                    0, 0, 0, 1, 2, 2,
+                                    1, 2, 1 };
+  fifo_prio_t prio;
+  size_t      i;
+
+  test__lanes(&prio, FIFO_PRIO__WEIGHTED, weights, 3);
+
+  test__push(&prio, 0, 6);
+  test__push(&prio, 1, 4);
+  test__push(&prio, 2, 5);
+
+  for (i = 0; i < sizeof(order) / sizeof(order[0]); i ++) {
+    assert(test__pop(&prio) == order[i]);
+  }
+
+  assert(fifo_prio__is_empty(&prio));
+
+  /* A lane that ran out of credit waits for the next round, in which the
+   * higher lanes come first again
+   */
+  test__push(&prio, 1, 1);
+  assert(test__pop(&prio) == 1);
+  test__push(&prio, 0, 4);
+  test__push(&prio, 1, 1);
+  assert(test__pop(&prio) == 0);
+  assert(test__pop(&prio) == 0);
+  assert(test__pop(&prio) == 0);
+  assert(test__pop(&prio) == 0);
+  assert(test__pop(&prio) == 1);
+  assert(fifo_prio__is_empty(&prio));
+}
+
+int main(int argc, char *argv[])
+{
+  test__ctor();
+  test__strict();
+  test__weighted();
+
+  puts("fifo prio passed all tests");
+
+  return 0;
+}
@@ -0,0 +1,129 @@
+#include <fifo.hpp>
+
+#include <memory>
+#include <string>
+#include <thread>
+
+#define TEST__TRANSFER_COUNT                        200000
+
+
+void test__capacity(void)
+{
+  static_assert(fifo::ring<int, 8>::capacity() == 8);
+  static_assert(fifo::ring<int, 8>::mask == 7);
+
+  fifo::ring<int, 4> ring;
+
+  assert(ring.empty());
+  assert(ring.available() == 4);
+  assert(!ring.pop());
+
+  for (int i = 0; i < 4; i ++) {
+    assert(ring.push(i));
+  }
+
+  assert(ring.full());
+  assert(!ring.push(4));
+
+  /* Elements come out in order, also after wrapping around */
+  for (int i = 0; i < 10; i ++) {
+    assert(ring.front() == i);
+    assert(ring.pop() == i);
+    assert(ring.push(i + 4));
+  }
+}
+
+void test__move_only(void)
+{
+  fifo::ring<std::unique_ptr<std::string>, 4> ring;
+  std::unique_ptr<std::string>                value;
+
+  /* Elements are constructed in place and moved out */
+  assert(ring.emplace(new std::string("first")));
+  assert(ring.push(std::make_unique<std::string>(300, 'x')));
+  assert(ring.size() == 2);
+
+  assert(ring.pop(value));
+  assert(*value == "first");
+
+  std::optional<std::unique_ptr<std::string>> second = ring.pop();
+  assert(second && (*second)->size() == 300);
+
+  /* Elements left over are destroyed with the ring */
+  assert(ring.emplace(new std::string("left over")));
+  ring.clear();
+  assert(ring.empty());
+  assert(ring.emplace(new std::string("destroyed by the destructor")));
+}
+
+void test__views(void)
+{
+  fifo::ring<std::uint32_t, 8> ring;
+  std::uint32_t                next = 0;
+
+  /* Move the cursors to just before the edge */
+  for (int i = 0; i < 6; i ++) {
+    ring.push(0);
+    ring.pop();
+  }
+
+  auto free = ring.writable();
+  assert(free[0].size() == 2 && free[1].size() == 6);
+
+  for (auto &span : free) {
+    for (auto &element : span) {
+      element = next ++;
+    }
+  }
+
+  ring.commit(5);
+  assert(ring.size() == 5);
+
+  auto used = ring.readable();
+  assert(used[0].size() == 2 && used[1].size() == 3);
+  assert(used[0][0] == 0 && used[1][2] == 4);
+
+  ring.consume(3);
+  assert(ring.front() == 3);
+  assert(ring.readable()[0].size() == 2);
+}
+
+void test__threads(void)
+{
+  static fifo::ring<std::string, 64> ring;
+
+  std::thread producer([] {
+    for (int i = 0; i < TEST__TRANSFER_COUNT; i ++) {
+      std::string value = std::to_string(i);
+
+      while (!ring.push(std::move(value))) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  for (int i = 0; i < TEST__TRANSFER_COUNT; i ++) {
+    std::optional<std::string> value;
+
+    while (!(value = ring.pop())) {
+      std::this_thread::yield();
+    }
+
+    assert(*value == std::to_string(i));
+  }
+
+  producer.join();
+  assert(ring.empty());
+}
+
+int main(int argc, char *argv[])
+{
+  test__capacity();
+  test__move_only();
+  test__views();
+  test__threads();
+
+  puts("fifo ring passed all tests");
+
+  return 0;
+}
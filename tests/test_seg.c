@@ -0,0 +1,134 @@
+#include <compiler.h>
+#include <fifo_seg.h>
+
+#include "helper.h"
+
+#define TEST__SEGMENT_SIZE                          16
+
+
+static uint8_t test__data[1000];
+
+
+void test__grow_and_shrink(void)
+{
+  fifo_seg__pool_t pool;
+  fifo_seg_t       fifo;
+  uint8_t          read[sizeof(test__data)];
+
+  fifo_seg__pool_ctor(&pool, TEST__SEGMENT_SIZE, 0);
+  fifo_seg__ctor(&fifo, &pool);
+
+  assert(fifo_seg__is_empty(&fifo));
+  assert(fifo_seg__read(&fifo, read, sizeof(read)) == 0);
+
+  /* Grows one segment at a time, without limit */
+  assert(fifo_seg__write(&fifo, test__data, sizeof(test__data)) ==
+         sizeof(test__data));
+  assert(fifo_seg__used(&fifo) == sizeof(test__data));
+  assert(pool.allocated == (sizeof(test__data) + TEST__SEGMENT_SIZE - 1) /
+                           TEST__SEGMENT_SIZE);
+  assert(pool.available == 0);
+
+  /* Reads across segment boundaries, handing segments back as it goes */
+  assert(fifo_seg__read(&fifo, read, 5) == 5);
+  assert(fifo_seg__read(&fifo, read + 5, 40) == 40);
+  assert(pool.available == 2);
+
+  assert(fifo_seg__read(&fifo, read + 45, sizeof(read)) ==
+         sizeof(read) - 45);
+  assert(helper__is_equal(read, test__data, sizeof(read)));
+  assert(fifo_seg__is_empty(&fifo));
+
+  /* The last segment stays with the fifo */
+  assert(pool.available == pool.allocated - 1);
+
+  fifo_seg__dtor(&fifo);
+  assert(pool.available == pool.allocated);
+  fifo_seg__pool_dtor(&pool);
+}
+
+void test__steady_state(void)
+{
+  fifo_seg__pool_t pool;
+  fifo_seg_t       fifo;
+  uint8_t          read[100];
+  size_t           allocated;
+  size_t           i;
+
+  fifo_seg__pool_ctor(&pool, TEST__SEGMENT_SIZE, 0);
+  fifo_seg__ctor(&fifo, &pool);
+
+  /* Once the peak has been reached no more segments are allocated */
+  fifo_seg__write(&fifo, test__data, 100);
+  allocated = pool.allocated;
+
+  for (i = 0; i < 50; i ++) {
+    size_t const offset = (i * 37) % 100;
+
+    assert(fifo_seg__read(&fifo, read, 37) == 37);
+    assert(fifo_seg__write(&fifo, test__data + offset, 37) == 37);
+    assert(fifo_seg__used(&fifo) == 100);
+  }
+
+  assert(pool.allocated <= allocated + 1);
+
+  fifo_seg__dtor(&fifo);
+  fifo_seg__pool_dtor(&pool);
+}
+
+void test__limit(void)
+{
+  fifo_seg__pool_t pool;
+  fifo_seg_t       fifo_a;
+  fifo_seg_t       fifo_b;
+  uint8_t          read[4 * TEST__SEGMENT_SIZE];
+
+  fifo_seg__pool_ctor(&pool, TEST__SEGMENT_SIZE, 4);
+  assert(fifo_seg__pool_reserve(&pool, 3) == FIFO__OK);
+  assert(pool.available == 3);
+  assert(fifo_seg__pool_reserve(&pool, 5) == FIFO__INVALID_SIZE);
+  assert(pool.allocated == 4);
+
+  fifo_seg__ctor(&fifo_a, &pool);
+  fifo_seg__ctor(&fifo_b, &pool);
+
+  /* Both fifos share the limit of the pool */
+  assert(fifo_seg__write(&fifo_a, test__data, 3 * TEST__SEGMENT_SIZE) ==
+         3 * TEST__SEGMENT_SIZE);
+  assert(fifo_seg__write(&fifo_b, test__data, 2 * TEST__SEGMENT_SIZE) ==
+         TEST__SEGMENT_SIZE);
+  assert(fifo_seg__write(&fifo_a, test__data, 1) == 0);
+
+  /* Segments read from one fifo become available to the other */
+  assert(fifo_seg__read(&fifo_a, read, 2 * TEST__SEGMENT_SIZE) ==
+         2 * TEST__SEGMENT_SIZE);
+  assert(fifo_seg__write(&fifo_b, test__data + TEST__SEGMENT_SIZE,
+                         TEST__SEGMENT_SIZE) == TEST__SEGMENT_SIZE);
+  assert(fifo_seg__read(&fifo_b, read, sizeof(read)) ==
+         2 * TEST__SEGMENT_SIZE);
+  assert(helper__is_equal(read, test__data, 2 * TEST__SEGMENT_SIZE));
+
+  fifo_seg__flush(&fifo_a);
+  assert(fifo_seg__is_empty(&fifo_a));
+
+  fifo_seg__dtor(&fifo_a);
+  fifo_seg__dtor(&fifo_b);
+  fifo_seg__pool_dtor(&pool);
+}
+
+int main(int argc, char *argv[])
+{
+  size_t i;
+
+  for (i = 0; i < sizeof(test__data); i ++) {
+    test__data[i] = (uint8_t) (i * 7 + 3);
+  }
+
+  test__grow_and_shrink();
+  test__steady_state();
+  test__limit();
+
+  puts("fifo seg passed all tests");
+
+  return 0;
+}
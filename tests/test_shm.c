@@ -0,0 +1,158 @@
+#include <compiler.h>
+#include <fifo_shm.h>
+#include <sched.h>
+
+#include "helper.h"
+
+#ifdef __unix__
+
+#include <errno.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define TEST__TRANSFER_SIZE                         (1024 * 1024)
+
+static char test__name[32];
+
+
+void test__create_attach(void)
+{
+  fifo_shm_t producer;
+  fifo_shm_t consumer;
+  uint8_t    write[100];
+  uint8_t    read[100];
+  size_t     i;
+
+  for (i = 0; i < sizeof(write); i ++) {
+    write[i] = (uint8_t) (i * 7);
+  }
+
+  /* Rounded up to a power of 2 */
+  assert(fifo_shm__create(&producer, test__name, 100) == FIFO__OK);
+  assert(fifo_shm__size(&producer) == 128);
+
+  /* A second object of the same name cannot be created */
+  assert(fifo_shm__create(&consumer, test__name, 100) == FIFO__SYSTEM_ERROR);
+  assert(errno == EEXIST);
+
+  assert(fifo_shm__attach(&consumer, test__name) == FIFO__OK);
+  assert(fifo_shm__size(&consumer) == 128);
+
+  /* The two mappings are at different addresses but see the same data */
+  assert(producer.buffer != consumer.buffer);
+
+  for (i = 0; i < 10; i ++) {
+    assert(fifo_shm__write(&producer, write, sizeof(write)) == sizeof(write));
+    assert(fifo_shm__used(&consumer) == sizeof(write));
+    assert(fifo_shm__read(&consumer, read, sizeof(read)) == sizeof(read));
+    assert(helper__is_equal(read, write, sizeof(write)));
+  }
+
+  /* Writes beyond the free space are cut short */
+  assert(fifo_shm__write(&producer, write, sizeof(write)) == sizeof(write));
+  assert(fifo_shm__write(&producer, write, sizeof(write)) == 28);
+  assert(fifo_shm__available(&consumer) == 0);
+  assert(fifo_shm__read(&consumer, read, sizeof(read)) == sizeof(read));
+  assert(fifo_shm__read(&consumer, read, sizeof(read)) == 28);
+  assert(fifo_shm__read(&consumer, read, sizeof(read)) == 0);
+
+  fifo_shm__detach(&consumer);
+  fifo_shm__detach(&producer);
+  assert(consumer.header == NULL);
+
+  assert(fifo_shm__unlink(test__name) == FIFO__OK);
+  assert(fifo_shm__attach(&consumer, test__name) == FIFO__SYSTEM_ERROR);
+  assert(errno == ENOENT);
+}
+
+void test__other_process(void)
+{
+  fifo_shm_t fifo;
+  uint8_t    data[1000];
+  size_t     received = 0;
+  int        status;
+  pid_t      child;
+
+  assert(fifo_shm__create(&fifo, test__name, 4096) == FIFO__OK);
+
+  child = fork();
+  assert(child >= 0);
+
+  if (child == 0) {
+    fifo_shm_t producer;
+    size_t     sent = 0;
+
+    if (fifo_shm__attach(&producer, test__name) != FIFO__OK) {
+      _exit(1);
+    }
+
+    while (sent < TEST__TRANSFER_SIZE) {
+      size_t len = TEST__TRANSFER_SIZE - sent;
+      size_t i;
+
+      if (len > sizeof(data)) {
+        len = sizeof(data);
+      }
+
+      for (i = 0; i < len; i ++) {
+        data[i] = (uint8_t) ((sent + i) * 31);
+      }
+
+      len = fifo_shm__write(&producer, data, len);
+
+      if (len == 0) {
+        sched_yield();
+      }
+
+      sent += len;
+    }
+
+    fifo_shm__detach(&producer);
+    _exit(0);
+  }
+
+  while (received < TEST__TRANSFER_SIZE) {
+    size_t const len = fifo_shm__read(&fifo, data, sizeof(data));
+    size_t i;
+
+    for (i = 0; i < len; i ++) {
+      assert(data[i] == (uint8_t) ((received + i) * 31));
+    }
+
+    if (len == 0) {
+      sched_yield();
+    }
+
+    received += len;
+  }
+
+  assert(waitpid(child, &status, 0) == child);
+  assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  assert(fifo_shm__used(&fifo) == 0);
+
+  fifo_shm__detach(&fifo);
+  assert(fifo_shm__unlink(test__name) == FIFO__OK);
+}
+
+int main(int argc, char *argv[])
+{
+  snprintf(test__name, sizeof(test__name), "/test_shm_%ld", (long) getpid());
+
+  test__create_attach();
+  test__other_process();
+
+  puts("fifo shm passed all tests");
+
+  return 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+  puts("fifo shm skipped, shared memory needs a Unix like system");
+
+  return 0;
+}
+
+#endif
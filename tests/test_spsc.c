@@ -0,0 +1,165 @@
+#include <compiler.h>
+#include <fifo.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+
+#include "helper.h"
+
+/* These tests only run when the library is built in SPSC mode, e.g.
+ * make test CC="gcc -DFIFO__SPSC"
+ * or with the cache aligned layout
+ * make test CC="gcc -DFIFO__SPSC -DFIFO__CACHE_ALIGNED"
+ */
+
+#define TEST__TRANSFER_SIZE                         (1024 * 1024)
+
+#ifdef FIFO__SPSC
+
+static uint8_t test__buffer[256];
+
+
+static void *test__producer(void *arg)
+{
+  fifo_t  *fifo = (fifo_t *) arg;
+  uint8_t  chunk[37];
+  uint8_t  next = 0;
+  size_t   sent = 0;
+  size_t   len  = 1;
+  size_t   i;
+
+  while (sent < TEST__TRANSFER_SIZE) {
+    size_t ret;
+
+    for (i = 0; i < len; i ++) {
+      chunk[i] = next + i;
+    }
+
+    ret = fifo__write(fifo, chunk, len);
+
+    /* Let the consumer run on single core machines */
+    if (ret == 0) {
+      sched_yield();
+    }
+
+    next += ret;
+    sent += ret;
+    len   = len % sizeof(chunk) + 1;
+  }
+
+  return NULL;
+}
+
+void test__concurrent_transfer(void)
+{
+  fifo_t    fifo;
+  pthread_t producer;
+  uint8_t   chunk[41];
+  uint8_t   next     = 0;
+  size_t    received = 0;
+  size_t    len      = 1;
+  size_t    i;
+
+  fifo__ctor(&fifo, test__buffer, sizeof(test__buffer));
+
+  pthread_create(&producer, NULL, test__producer, &fifo);
+
+  while (received < TEST__TRANSFER_SIZE) {
+    size_t ret = fifo__read(&fifo, chunk, len);
+
+    if (ret == 0) {
+      sched_yield();
+    }
+
+    for (i = 0; i < ret; i ++) {
+      assert(chunk[i] == next);
+      next ++;
+    }
+
+    assert(fifo__used(&fifo) <= fifo__size(&fifo));
+
+    received += ret;
+    len       = len % sizeof(chunk) + 1;
+  }
+
+  pthread_join(producer, NULL);
+
+  assert(received == TEST__TRANSFER_SIZE);
+  assert(fifo__is_empty(&fifo));
+}
+
+void test__full_without_flag(void)
+{
+  fifo_t  fifo;
+  uint8_t buffer[8];
+  uint8_t read[8];
+
+  fifo__ctor(&fifo, buffer, sizeof(buffer));
+
+  /* The mask is never modified by read or write */
+  assert(fifo__write(&fifo, "abcdefgh", 8) == 8);
+  assert(fifo__is_full(&fifo));
+  assert(fifo.mask == 7);
+
+  assert(fifo__read(&fifo, read, 3) == 3);
+  assert(fifo__available(&fifo) == 3);
+  assert(fifo.mask == 7);
+
+  fifo__flush(&fifo);
+  assert(fifo__is_empty(&fifo));
+}
+
+void test__cached_cursors(void)
+{
+  fifo_t  fifo;
+  uint8_t buffer[8];
+  uint8_t read[8];
+
+  fifo__ctor(&fifo, buffer, sizeof(buffer));
+
+#ifdef FIFO__CACHE_ALIGNED
+  /* Producer and consumer state must not share a cache line */
+  assert(offsetof(fifo_t, read) - offsetof(fifo_t, write) >= CACHE_LINE_SIZE);
+  assert(offsetof(fifo_t, write) >= CACHE_LINE_SIZE);
+#endif
+
+  assert(fifo__write(&fifo, "abcdefgh", 8) == 8);
+  assert(fifo__read(&fifo, read, 3) == 3);
+
+  /* The producer still believes the fifo is full and has to look again */
+  assert(fifo__write(&fifo, "ij", 2) == 2);
+#ifdef FIFO__CACHE_ALIGNED
+  assert(fifo.read_cache == 3);
+  assert(fifo.write_cache == 8);
+#endif
+
+  /* The consumer only knows about 5 bytes and has to look again */
+  assert(fifo__read(&fifo, read, 7) == 7);
+  assert(memcmp(read, "defghij", 7) == 0);
+#ifdef FIFO__CACHE_ALIGNED
+  assert(fifo.write_cache == 10);
+#endif
+  assert(fifo__is_empty(&fifo));
+}
+
+int main(int argc, char *argv[])
+{
+  test__full_without_flag();
+  test__cached_cursors();
+  test__concurrent_transfer();
+
+  puts("fifo spsc passed all tests");
+
+  return 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+  puts("fifo spsc skipped, the library is not built in SPSC mode");
+
+  return 0;
+}
+
+#endif
@@ -0,0 +1,64 @@
+#include <compiler.h>
+#include <fifo_static.h>
+
+#include "helper.h"
+
+
+FIFO_DEFINE_STATIC(test__fifo, 8)
+
+static test__fifo_t test__zeroed;
+
+
+void test__zero_initialized(void)
+{
+  uint8_t read[4];
+
+  /* A static fifo is usable without a constructor call */
+  assert(test__fifo__size(&test__zeroed) == 8);
+  assert(test__fifo__is_empty(&test__zeroed));
+  assert(test__fifo__read(&test__zeroed, read, sizeof(read)) == 0);
+
+  assert(test__fifo__write(&test__zeroed, "abcd", 4) == 4);
+  assert(test__fifo__read(&test__zeroed, read, sizeof(read)) == 4);
+  assert(helper__is_equal(read, (uint8_t const *) "abcd", 4));
+}
+
+void test__write_read(void)
+{
+  test__fifo_t fifo;
+  uint8_t write[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+  uint8_t read[10];
+
+  test__fifo__ctor(&fifo);
+
+  /* Writes stop when the fifo is full */
+  assert(test__fifo__write(&fifo, write, sizeof(write)) == 8);
+  assert(test__fifo__is_full(&fifo));
+  assert(test__fifo__available(&fifo) == 0);
+
+  assert(test__fifo__read(&fifo, read, 5) == 5);
+  assert(helper__is_equal(read, write, 5));
+
+  /* [9 10 3 . . 6 7 8] wraps around the edge */
+  assert(test__fifo__write(&fifo, write + 8, 2) == 2);
+  assert(test__fifo__write(&fifo, write + 2, 1) == 1);
+  assert(test__fifo__used(&fifo) == 6);
+
+  assert(test__fifo__read(&fifo, read, sizeof(read)) == 6);
+  assert(helper__is_equal(read, write + 5, 5));
+  assert(read[5] == 3);
+
+  assert(test__fifo__write(&fifo, write, 3) == 3);
+  test__fifo__flush(&fifo);
+  assert(test__fifo__is_empty(&fifo));
+}
+
+int main(int argc, char *argv[])
+{
+  test__zero_initialized();
+  test__write_read();
+
+  puts("fifo static passed all tests");
+
+  return 0;
+}
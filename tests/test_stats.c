@@ -0,0 +1,222 @@
+#include <compiler.h>
+#include <fifo.h>
+
+#include "helper.h"
+
+/* These tests only run when the library is built with statistics, e.g.
+ * make test CC="gcc -DFIFO__STATS"
+ * and should also pass with the cached cursors of
+ * make test CC="gcc -DFIFO__STATS -DFIFO__SPSC -DFIFO__CACHE_ALIGNED"
+ */
+
+#ifdef FIFO__STATS
+
+void test__fresh(void)
+{
+  fifo_t       *fifo = helper__setup_fifo();
+  fifo__stats_t stats;
+
+  fifo__stats(fifo, &stats);
+
+  assert(stats.bytes_written == 0);
+  assert(stats.bytes_read    == 0);
+  assert(stats.short_writes  == 0);
+  assert(stats.empty_reads   == 0);
+  assert(stats.high_water    == 0);
+  assert(stats.resizes       == 0);
+}
+
+void test__bytes(void)
+{
+  fifo_t       *fifo = helper__setup_fifo();
+  uint8_t       data[HELPER__BUFFER_SIZE * 2] = { 0 };
+  fifo__stats_t stats;
+
+  /* [1 2 3 4 5 . . .] */
+  assert(fifo__write(fifo, data, 5) == 5);
+  assert(fifo__read(fifo, data, 2) == 2);
+
+  /* Only 5 of the 8 bytes fit, the write is short */
+  assert(fifo__write(fifo, data, 8) == 5);
+  assert(fifo__is_full(fifo));
+
+  fifo__stats(fifo, &stats);
+
+  assert(stats.bytes_written == 10);
+  assert(stats.bytes_read    == 2);
+  assert(stats.short_writes  == 1);
+  assert(stats.high_water    == HELPER__BUFFER_SIZE);
+
+  /* A write to a full fifo is short as well */
+  assert(fifo__write(fifo, data, 1) == 0);
+  assert(fifo__read(fifo, data, sizeof(data)) == HELPER__BUFFER_SIZE);
+  assert(fifo__read(fifo, data, 1) == 0);
+
+  fifo__stats(fifo, &stats);
+
+  assert(stats.bytes_written == 10);
+  assert(stats.bytes_read    == 10);
+  assert(stats.short_writes  == 2);
+  assert(stats.empty_reads   == 1);
+  assert(stats.high_water    == HELPER__BUFFER_SIZE);
+}
+
+void test__reserve_commit(void)
+{
+  fifo_t        *fifo = helper__setup_fifo();
+  fifo__region_t regions[2];
+  fifo__stats_t  stats;
+
+  fifo__write_reserve(fifo, regions);
+  fifo__write_commit(fifo, 3);
+
+  fifo__read_peek(fifo, regions);
+  fifo__read_consume(fifo, 1);
+
+  fifo__stats(fifo, &stats);
+
+  assert(stats.bytes_written == 3);
+  assert(stats.bytes_read    == 1);
+  assert(stats.high_water    == 3);
+}
+
+void test__flush_and_evict(void)
+{
+  fifo_t       *fifo = helper__setup_fifo();
+  uint8_t       data[HELPER__BUFFER_SIZE + 2] = { 0 };
+  fifo__stats_t stats;
+
+  /* Evicted and flushed bytes count as read, so that the difference of
+     written and read bytes is always the number of bytes in the fifo */
+  fifo__write_force(fifo, data, sizeof(data));
+
+  fifo__stats(fifo, &stats);
+  assert(stats.bytes_written - stats.bytes_read == fifo__used(fifo));
+
+  fifo__flush(fifo);
+
+  fifo__stats(fifo, &stats);
+  assert(stats.bytes_written == stats.bytes_read);
+}
+
+void test__messages(void)
+{
+  fifo_t       *fifo = helper__setup_fifo();
+  uint8_t       data[HELPER__BUFFER_SIZE] = { 0 };
+  size_t        len;
+  fifo__stats_t stats;
+
+  assert(fifo__pop_msg(fifo, data, sizeof(data), &len) == FIFO__EMPTY);
+  assert(fifo__push_msg(fifo, data, 4) == FIFO__OK);
+  assert(fifo__push_msg(fifo, data, 4) == FIFO__FULL);
+
+  fifo__stats(fifo, &stats);
+
+  assert(stats.bytes_written == 5);
+  assert(stats.short_writes  == 1);
+  assert(stats.empty_reads   == 1);
+}
+
+#ifdef __unix__
+void test__writev(void)
+{
+  fifo_t       *fifo = helper__setup_fifo();
+  uint8_t       data[HELPER__BUFFER_SIZE] = { 0 };
+  struct iovec  iov[] = {
+    { .iov_base = data, .iov_len = HELPER__BUFFER_SIZE },
+    { .iov_base = data, .iov_len = 1 },
+  };
+  fifo__stats_t stats;
+
+  /* The first buffer fills the fifo and the second one does not fit */
+  fifo__writev(fifo, iov, 2);
+
+  fifo__stats(fifo, &stats);
+  assert(stats.short_writes  == 1);
+  assert(stats.bytes_written == HELPER__BUFFER_SIZE);
+
+  /* A write into the full fifo is short as well */
+  fifo__writev(fifo, iov, 2);
+
+  fifo__stats(fifo, &stats);
+  assert(stats.short_writes  == 2);
+  assert(stats.bytes_written == HELPER__BUFFER_SIZE);
+}
+#endif
+
+void test__resizes(void)
+{
+  fifo_t       *fifo = helper__setup_fifo();
+  uint8_t       data[HELPER__BUFFER_SIZE] = { 0 };
+  fifo__stats_t stats;
+
+  /* An empty fifo resized to a size that rounds down to its own is left
+     alone, and no resize is counted */
+  assert(fifo__resize(fifo, HELPER__BUFFER_SIZE + 4) == FIFO__OK);
+  assert(fifo__size(fifo) == HELPER__BUFFER_SIZE);
+
+  fifo__stats(fifo, &stats);
+  assert(stats.resizes == 0);
+
+  fifo__write(fifo, data, 6);
+
+  assert(fifo__resize(fifo, HELPER__BUFFER_SIZE_GROW) == FIFO__OK);
+  assert(fifo__resize(fifo, HELPER__BUFFER_SIZE_SHRINK) != FIFO__OK);
+
+  fifo__stats(fifo, &stats);
+
+  assert(stats.resizes       == 1);
+  assert(stats.bytes_written == 6);
+}
+
+void test__high_water_cycles(void)
+{
+  fifo16_t      fifo;
+  uint8_t       buffer[64];
+  uint8_t       data = 0;
+  fifo__stats_t stats;
+  size_t        i;
+
+  fifo16__ctor(&fifo, buffer, sizeof(buffer));
+
+  /* The fifo never holds more than one byte, however far a cached copy of the
+     read cursor lags behind */
+  for (i = 0; i < 50; i ++) {
+    assert(fifo16__write(&fifo, &data, 1) == 1);
+    assert(fifo16__read(&fifo, &data, 1) == 1);
+  }
+
+  fifo16__stats(&fifo, &stats);
+
+  assert(stats.bytes_written == 50);
+  assert(stats.high_water    == 1);
+}
+
+int main(int argc, char *argv[])
+{
+  test__fresh();
+  test__bytes();
+  test__reserve_commit();
+  test__flush_and_evict();
+  test__messages();
+#ifdef __unix__
+  test__writev();
+#endif
+  test__resizes();
+  test__high_water_cycles();
+
+  puts("fifo stats passed all tests");
+
+  return 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+  puts("fifo stats skipped, the library is not built with FIFO__STATS");
+
+  return 0;
+}
+
+#endif
@@ -0,0 +1,112 @@
+#include <compiler.h>
+#include <fifo_typed.h>
+
+#include "helper.h"
+
+
+typedef struct {
+  uint32_t id;
+  uint8_t  payload[28];
+} test__record_t;
+
+FIFO_DECLARE(test__record_fifo, test__record_t)
+FIFO_DECLARE(test__word_fifo, uint64_t)
+
+
+static test__record_t test__record(uint32_t id)
+{
+  test__record_t record;
+
+  record.id = id;
+  memset(record.payload, (uint8_t) id, sizeof(record.payload));
+
+  return record;
+}
+
+void test__push_pop(void)
+{
+  test__record_t      buffer[4];
+  test__record_fifo_t fifo;
+  test__record_t      record;
+  uint32_t            i;
+
+  test__record_fifo__ctor(&fifo, buffer, 4);
+
+  assert(test__record_fifo__size(&fifo) == 4);
+  assert(test__record_fifo__is_empty(&fifo));
+  assert(!test__record_fifo__pop(&fifo, &record));
+
+  for (i = 0; i < 4; i ++) {
+    record = test__record(i);
+    assert(test__record_fifo__push(&fifo, &record));
+  }
+
+  assert(test__record_fifo__is_full(&fifo));
+  assert(!test__record_fifo__push(&fifo, &record));
+
+  /* Whole elements come out, also after wrapping around */
+  for (i = 0; i < 10; i ++) {
+    assert(test__record_fifo__pop(&fifo, &record));
+    assert(record.id == i);
+    assert(record.payload[27] == (uint8_t) i);
+
+    record = test__record(i + 4);
+    assert(test__record_fifo__push(&fifo, &record));
+    assert(test__record_fifo__used(&fifo) == 4);
+  }
+
+  test__record_fifo__flush(&fifo);
+  assert(test__record_fifo__is_empty(&fifo));
+  assert(test__record_fifo__available(&fifo) == 4);
+}
+
+void test__uneven_size(void)
+{
+  uint64_t          buffer[6];
+  test__word_fifo_t fifo;
+
+  /* Rounded down to a power of 2 */
+  test__word_fifo__ctor(&fifo, buffer, 6);
+  assert(test__word_fifo__size(&fifo) == 4);
+
+  test__word_fifo__ctor(&fifo, buffer, 1);
+  assert(test__word_fifo__size(&fifo) == 1);
+}
+
+void test__bulk(void)
+{
+  uint64_t          buffer[8];
+  test__word_fifo_t fifo;
+  uint64_t          write[12];
+  uint64_t          read[12];
+  size_t            i;
+
+  for (i = 0; i < 12; i ++) {
+    write[i] = 0x0101010101010101 * i;
+  }
+
+  test__word_fifo__ctor(&fifo, buffer, 8);
+
+  assert(test__word_fifo__write(&fifo, write, 12) == 8);
+  assert(test__word_fifo__read(&fifo, read, 5) == 5);
+  assert(helper__is_equal((uint8_t *) read, (uint8_t *) write,
+                          5 * sizeof(uint64_t)));
+
+  /* [8 9 10 . . 5 6 7] */
+  assert(test__word_fifo__write(&fifo, write + 8, 3) == 3);
+  assert(test__word_fifo__read(&fifo, read, 12) == 6);
+  assert(helper__is_equal((uint8_t *) read, (uint8_t *) (write + 5),
+                          6 * sizeof(uint64_t)));
+  assert(test__word_fifo__is_empty(&fifo));
+}
+
+int main(int argc, char *argv[])
+{
+  test__push_pop();
+  test__uneven_size();
+  test__bulk();
+
+  puts("fifo typed passed all tests");
+
+  return 0;
+}
@@ -0,0 +1,157 @@
+#include <compiler.h>
+#include <fifo.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "helper.h"
+
+/* These tests only run when the library is built with blocking waits, e.g.
+ * make test CC="gcc -DFIFO__SPSC -DFIFO__WAIT"
+ */
+
+#define TEST__TRANSFER_SIZE                         (13 * 7 * 4096)
+
+#ifdef FIFO__WAIT
+
+static uint8_t test__buffer[64];
+
+
+static double test__now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *test__late_writer(void *arg)
+{
+  fifo_t *fifo = (fifo_t *) arg;
+
+  usleep(20000);
+  fifo__write(fifo, "abc", 3);
+
+  return NULL;
+}
+
+static void *test__producer(void *arg)
+{
+  fifo_t  *fifo = (fifo_t *) arg;
+  uint8_t  chunk[13];
+  uint8_t  next = 0;
+  size_t   sent = 0;
+  size_t   i;
+
+  while (sent < TEST__TRANSFER_SIZE) {
+    assert(fifo__write_wait(fifo, sizeof(chunk), -1) == FIFO__OK);
+
+    for (i = 0; i < sizeof(chunk); i ++) {
+      chunk[i] = next ++;
+    }
+
+    assert(fifo__write(fifo, chunk, sizeof(chunk)) == sizeof(chunk));
+    sent += sizeof(chunk);
+  }
+
+  return NULL;
+}
+
+void test__timeout(void)
+{
+  fifo_t fifo;
+  double start;
+
+  fifo__ctor(&fifo, test__buffer, sizeof(test__buffer));
+
+  /* A zero timeout only checks */
+  assert(fifo__read_wait(&fifo, 1, 0) == FIFO__EMPTY);
+  assert(fifo__write_wait(&fifo, 64, 0) == FIFO__OK);
+
+  start = test__now();
+  assert(fifo__read_wait(&fifo, 1, 20) == FIFO__EMPTY);
+  assert(test__now() - start >= 0.02);
+
+  /* Not enough space for 5 bytes */
+  fifo__write(&fifo, test__buffer, 60);
+  assert(fifo__read_wait(&fifo, 60, 20) == FIFO__OK);
+  assert(fifo__write_wait(&fifo, 5, 20) == FIFO__FULL);
+  assert(fifo__write_wait(&fifo, 4, 20) == FIFO__OK);
+}
+
+void test__wake_up(void)
+{
+  fifo_t    fifo;
+  pthread_t writer;
+  uint8_t   read[3];
+
+  fifo__ctor(&fifo, test__buffer, sizeof(test__buffer));
+
+  pthread_create(&writer, NULL, test__late_writer, &fifo);
+
+  assert(fifo__read_wait(&fifo, 1, -1) == FIFO__OK);
+  assert(fifo__read(&fifo, read, 3) == 3);
+  assert(memcmp(read, "abc", 3) == 0);
+
+  pthread_join(writer, NULL);
+}
+
+void test__blocking_transfer(void)
+{
+  fifo_t    fifo;
+  pthread_t producer;
+  uint8_t   chunk[7];
+  uint8_t   next     = 0;
+  size_t    received = 0;
+  size_t    i;
+
+  fifo__ctor(&fifo, test__buffer, sizeof(test__buffer));
+
+  pthread_create(&producer, NULL, test__producer, &fifo);
+
+  /* Neither side ever spins, both sleep until the other one wakes them */
+  while (received < TEST__TRANSFER_SIZE) {
+    size_t len = TEST__TRANSFER_SIZE - received;
+
+    if (len > sizeof(chunk)) {
+      len = sizeof(chunk);
+    }
+
+    assert(fifo__read_wait(&fifo, len, -1) == FIFO__OK);
+    assert(fifo__read(&fifo, chunk, len) == len);
+
+    for (i = 0; i < len; i ++) {
+      assert(chunk[i] == next);
+      next ++;
+    }
+
+    received += len;
+  }
+
+  pthread_join(producer, NULL);
+
+  assert(fifo__is_empty(&fifo));
+}
+
+int main(int argc, char *argv[])
+{
+  test__timeout();
+  test__wake_up();
+  test__blocking_transfer();
+
+  puts("fifo wait passed all tests");
+
+  return 0;
+}
+
+#else
+
+int main(int argc, char *argv[])
+{
+  puts("fifo wait skipped, the library is not built with FIFO__WAIT");
+
+  return 0;
+}
+
+#endif